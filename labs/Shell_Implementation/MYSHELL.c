@@ -9,6 +9,7 @@
 #include <signal.h>  // Signal handling functions (e.g., sigaction, SIGCHLD)
 #include <fcntl.h>   // File control functions (e.g., open, close)
 #include <errno.h>   // Error handling functions (e.g., errno, perror)
+#include <spawn.h>   // posix_spawnp() and its attributes
 
 #define MAX_INPUT_LEN 1024 // Maximum length of user input (1024 characters)
 #define MAX_ARGS 100       // Maximum number of arguments for a command (100)
@@ -16,6 +17,9 @@
 // Global file descriptor for the shell.log file
 static int log_fd;
 
+// Launch external commands with fork() + execvp() instead of posix_spawnp() (--fork)
+static int use_fork = 0;
+
 // ----------------------------
 // SIGCHLD Handler
 // ----------------------------
@@ -236,15 +240,15 @@ char **parse_input(char *input, int *is_background) {
     return args;
 }
 
-void expand_environment_variables(char ***args_ptr) {
-
-    char **args = *args_ptr;
+// Returns a new token array with $VARIABLES expanded and frees the old tokens
+// (not the old array). Returns NULL, leaving args untouched, if out of memory.
+char **expand_environment_variables(char **args) {
 
     // Allocate memory for a new array to store the expanded token
     char **new_args = malloc(MAX_ARGS * sizeof(char *));
     if (!new_args) {
         perror("malloc");
-        return;
+        return NULL;
     }
 
     int new_i = 0;
@@ -293,28 +297,84 @@ void expand_environment_variables(char ***args_ptr) {
     for (int i = 0; args[i] != NULL; i++) {
         free(args[i]);
     }
-    *args_ptr = new_args;
+    return new_args;
 }
 
 // ----------------------------
-// External Commands
+// Launching External Commands
 // ----------------------------
-void execute_command(char **args, int is_background) {
-    // Expand environment variables in args,
-    // and update args with the new token array.
-    expand_environment_variables(&args);
+
+// Default path: posix_spawnp(). glibc starts the child with a vfork-style clone that
+// shares the shell's memory until the exec, so no page tables are copied and the
+// cost does not grow with the shell's size. Returns the child's pid, or -1.
+static pid_t spawn_command(char **args) {
+
+    extern char **environ;
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+
+    // The child starts with nothing blocked and with default job-control signal
+    // dispositions, as it would after fork() + execvp() from a fresh shell
+    sigset_t none, defaults;
+    sigemptyset(&none);
+    sigemptyset(&defaults);
+    int reset[] = { SIGCHLD, SIGINT, SIGQUIT, SIGTSTP, SIGTTIN, SIGTTOU, SIGPIPE };
+    for (size_t i = 0; i < sizeof(reset) / sizeof(reset[0]); i++) {
+        sigaddset(&defaults, reset[i]);
+    }
+    posix_spawnattr_setsigmask(&attr, &none);
+    posix_spawnattr_setsigdefault(&attr, &defaults);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+
+    // No file actions: the log file is close-on-exec, everything else is inherited
+    pid_t pid;
+    int err = posix_spawnp(&pid, args[0], NULL, &attr, args, environ);
+    posix_spawnattr_destroy(&attr);
+    if (err != 0) {
+        fprintf(stderr, "%s: %s\n", args[0], strerror(err)); // e.g. command not found
+        return -1;
+    }
+    return pid;
+}
+
+// --fork path: the classic fork() + execvp()
+static pid_t fork_command(char **args) {
 
     pid_t pid = fork(); // Create a child process
 
     if (pid < 0) {
         perror("fork failed");
-        return;
-
+        return -1;
     } 
     else if (pid == 0) { // Child process
         execvp(args[0], args); // Execute the command
         perror("execvp failed"); // Only reached if execvp fails
         exit(EXIT_FAILURE);
+    }
+    return pid;
+}
+
+// ----------------------------
+// External Commands
+// ----------------------------
+void execute_command(char **args, int is_background) {
+    // Expand environment variables into a new token array.
+    // The caller's array is left for the caller to free.
+    char **expanded = expand_environment_variables(args);
+    if (!expanded) {
+        // Expansion failed: free the original tokens and launch nothing
+        for (int i = 0; args[i] != NULL; i++) {
+            free(args[i]);
+        }
+        return;
+    }
+    args = expanded;
+
+    // Create the child process (unless every token expanded to nothing)
+    pid_t pid = !args[0] ? -1 : use_fork ? fork_command(args) : spawn_command(args);
+
+    if (pid < 0) {
+        // Nothing was started; any error has been reported
     } 
     else if (!is_background) { // Parent process (foreground)
         waitpid(pid, NULL, 0); // Wait for the child to finish
@@ -327,17 +387,24 @@ void execute_command(char **args, int is_background) {
     for (int i = 0; args[i] != NULL; i++) {
         free(args[i]);
     }
-    
+    free(args);
+
 }
 
 
 // ----------------------------
 // Main Program
 // ----------------------------
-int main(void) {
+int main(int argc, char *argv[]) {
+
+    // --fork: launch commands the classic way (to compare against posix_spawnp())
+    if (argc > 1 && strcmp(argv[1], "--fork") == 0) {
+        use_fork = 1;
+    }
 
-    // Open the log file for writing (create it if it doesn't exist, append if it does)
-    log_fd = open("shell.log", O_WRONLY | O_CREAT | O_APPEND, 0644);
+    // Open the log file for writing (create it if it doesn't exist, append if it does).
+    // Close-on-exec, so commands started by the shell do not inherit it.
+    log_fd = open("shell.log", O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
     if (log_fd == -1) {
         perror("open"); // Print an error if the file cannot be opened
         return EXIT_FAILURE; // Exit the program with a failure status
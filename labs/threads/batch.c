@@ -0,0 +1,276 @@
+#include <stdio.h>     // Standard I/O functions
+#include <stdlib.h>    // Memory management
+#include <string.h>    // String management
+#include <pthread.h>   // Loader and writer threads
+#include <stdatomic.h> // Stop flag shared by the stages
+#include "batch.h"
+#include "multiply.h"
+
+// One product on its way through the stages
+typedef struct {
+    size_t index;      // 1-based position in the batch
+    Matrix *A, *B, *C;
+    char *out;         // Output file (NULL: stdout)
+} BatchItem;
+
+static void free_item(BatchItem *item) {
+
+    free_matrix(item->A);
+    free_matrix(item->B);
+    free_matrix(item->C);
+    free(item->out);
+    free(item);
+}
+
+//------------------------------
+// Bounded Queues
+//------------------------------
+// One producer and one consumer; a NULL item marks the end of the batch
+
+typedef struct {
+    BatchItem *items[BATCH_QUEUE_DEPTH];
+    size_t head;       // Oldest item
+    size_t count;
+    pthread_mutex_t mutex;
+    pthread_cond_t changed;
+} BatchQueue;
+
+static void queue_init(BatchQueue *q) {
+
+    q->head = q->count = 0;
+    pthread_mutex_init(&q->mutex, NULL);
+    pthread_cond_init(&q->changed, NULL);
+}
+
+static void queue_destroy(BatchQueue *q) {
+
+    pthread_mutex_destroy(&q->mutex);
+    pthread_cond_destroy(&q->changed);
+}
+
+// Blocks while the queue is full
+static void queue_push(BatchQueue *q, BatchItem *item) {
+
+    pthread_mutex_lock(&q->mutex);
+    while (q->count == BATCH_QUEUE_DEPTH) pthread_cond_wait(&q->changed, &q->mutex);
+    q->items[(q->head + q->count) % BATCH_QUEUE_DEPTH] = item;
+    q->count++;
+    pthread_cond_broadcast(&q->changed);
+    pthread_mutex_unlock(&q->mutex);
+}
+
+// Blocks while the queue is empty
+static BatchItem *queue_pop(BatchQueue *q) {
+
+    pthread_mutex_lock(&q->mutex);
+    while (q->count == 0) pthread_cond_wait(&q->changed, &q->mutex);
+    BatchItem *item = q->items[q->head];
+    q->head = (q->head + 1) % BATCH_QUEUE_DEPTH;
+    q->count--;
+    pthread_cond_broadcast(&q->changed);
+    pthread_mutex_unlock(&q->mutex);
+    return item;
+}
+
+//------------------------------
+// Loader and Writer Threads
+//------------------------------
+
+typedef struct {
+    const char *manifest;   // NULL: matrix stream on stdin
+    MatrixType type;
+    int binary_out;
+    BatchQueue loaded;      // Loader -> pool
+    BatchQueue computed;    // Pool -> writer
+    atomic_int stop;        // A stream cannot skip a product: the first error ends it
+    int load_failed;        // Owned by the loader until it is joined
+    int write_failed;       // Owned by the writer until it is joined
+} Batch;
+
+static BatchItem *new_item(size_t index) {
+
+    BatchItem *item = calloc(1, sizeof(BatchItem));
+    if (!item) 
+    {
+        perror("calloc");
+        exit(EXIT_FAILURE);
+    }
+    item->index = index;
+    return item;
+}
+
+// Manifest lines "A B out": both inputs are read before the item is queued
+static void load_manifest(Batch *batch, FILE *fp) {
+
+    char *line = NULL;
+    size_t line_cap = 0, line_no = 0, index = 0;
+    while (getline(&line, &line_cap, fp) > 0) 
+    {
+        line_no++;
+        char a[256], b[256], out[256];
+        int fields = sscanf(line, "%255s %255s %255s", a, b, out);
+        if (fields <= 0 || a[0] == '#') continue; // Blank line or comment
+        if (fields != 3) 
+        {
+            fprintf(stderr, "Error: %s:%zu: expected \"A B out\"\n", batch->manifest, line_no);
+            batch->load_failed = 1;
+            continue;
+        }
+
+        BatchItem *item = new_item(++index);
+        item->A = read_matrix_as(a, batch->type, NULL); // The pool is busy with earlier products
+        item->B = item->A ? read_matrix_as(b, batch->type, NULL) : NULL;
+        item->out = strdup(out);
+        if (!item->out) 
+        {
+            perror("strdup");
+            exit(EXIT_FAILURE);
+        }
+        if (!item->A || !item->B) 
+        {
+            fprintf(stderr, "Error reading input matrices for %s.\n", out);
+            batch->load_failed = 1;
+            free_item(item);
+            continue;
+        }
+        queue_push(&batch->loaded, item);
+    }
+    free(line);
+}
+
+// Pairs of matrices on stdin, until the stream ends or an error stops the batch
+static void load_stream(Batch *batch) {
+
+    for (size_t index = 1; !atomic_load(&batch->stop); index++) 
+    {
+        BatchItem *item = new_item(index);
+        int status = read_matrix_stream(stdin, batch->type, "stdin", &item->A);
+        if (status == 1) 
+        {
+            status = read_matrix_stream(stdin, batch->type, "stdin", &item->B);
+            if (status == 0) fprintf(stderr, "Error: stdin ends with an unpaired matrix\n");
+        }
+        if (status != 1) 
+        {
+            batch->load_failed = item->A != NULL || status < 0;
+            free_item(item);
+            return;
+        }
+        queue_push(&batch->loaded, item);
+    }
+}
+
+static void *loader_main(void *arg) {
+
+    Batch *batch = (Batch *)arg;
+    if (!batch->manifest) 
+    {
+        load_stream(batch);
+    }
+    else 
+    {
+        FILE *fp = fopen(batch->manifest, "r");
+        if (!fp) 
+        {
+            perror(batch->manifest);
+            batch->load_failed = 1;
+        }
+        else 
+        {
+            load_manifest(batch, fp);
+            fclose(fp);
+        }
+    }
+    queue_push(&batch->loaded, NULL);
+    return NULL;
+}
+
+static void *writer_main(void *arg) {
+
+    Batch *batch = (Batch *)arg;
+    BatchItem *item;
+    while ((item = queue_pop(&batch->computed))) 
+    {
+        int status = 0;
+        if (!item->out) 
+        {
+            status = write_matrix_stream(stdout, item->C);
+            if (status != 0) 
+            {
+                perror("stdout");
+                atomic_store(&batch->stop, 1);
+            }
+        }
+        else if (batch->binary_out) 
+        {
+            status = write_matrix_binary(item->out, item->C);
+        }
+        else 
+        {
+            status = write_matrix_to_file(item->out, item->C, NULL); // Reports its own errors
+        }
+        batch->write_failed |= status != 0;
+        free_item(item);
+    }
+    return NULL;
+}
+
+//------------------------------
+// Batch Driver
+//------------------------------
+
+int run_batch(const char *manifest, MatrixType type, int binary_out, int tile_l2, int tile_l1,
+              ThreadPool *pool) {
+
+    Batch batch = { strcmp(manifest, "-") == 0 ? NULL : manifest, type, binary_out };
+    queue_init(&batch.loaded);
+    queue_init(&batch.computed);
+    atomic_init(&batch.stop, 0);
+
+    pthread_t loader, writer;
+    if (pthread_create(&loader, NULL, loader_main, &batch) != 0
+        || pthread_create(&writer, NULL, writer_main, &batch) != 0) 
+    {
+        perror("pthread_create");
+        exit(EXIT_FAILURE);
+    }
+
+    // Compute on the pool, one product at a time, while the next inputs load and
+    // earlier products are written
+    int failed = 0;
+    BatchItem *item;
+    while ((item = queue_pop(&batch.loaded))) 
+    {
+        if (atomic_load(&batch.stop)) // Drain what the loader had already queued
+        {
+            free_item(item);
+            continue;
+        }
+        if (item->A->cols != item->B->rows) 
+        {
+            if (item->out) fprintf(stderr, "Error: Incompatible matrix dimensions for %s.\n", item->out);
+            else fprintf(stderr, "Error: Incompatible matrix dimensions for product %zu.\n", item->index);
+            if (!item->out) atomic_store(&batch.stop, 1);
+            failed = 1;
+            free_item(item);
+            continue;
+        }
+        item->C = create_matrix_typed(item->A->rows, item->B->cols, type);
+        TileMultArgs args = { item->A, item->B, item->C, tile_l2, tile_l1 };
+        submit_per_tile(pool, &args);
+        pool_wait(pool);
+
+        // Only C is still needed
+        free_matrix(item->A);
+        free_matrix(item->B);
+        item->A = item->B = NULL;
+        queue_push(&batch.computed, item);
+    }
+    queue_push(&batch.computed, NULL);
+
+    pthread_join(loader, NULL);
+    pthread_join(writer, NULL);
+    queue_destroy(&batch.loaded);
+    queue_destroy(&batch.computed);
+    return failed || batch.load_failed || batch.write_failed ? -1 : 0;
+}
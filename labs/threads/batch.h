@@ -0,0 +1,22 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "matrix.h"
+#include "pool.h"
+
+// Products queued between the loader, the pool and the writer (each stage holds
+// at most this many, so memory stays bounded however long the batch is)
+#define BATCH_QUEUE_DEPTH 2
+
+// Many products in one process: C = A x B for every (A, B, out) line of a manifest
+// file, or, with manifest "-", for every pair of dense text matrices concatenated on
+// stdin, writing the products to stdout in the same form. A loader thread reads the
+// next inputs and a writer thread writes finished products while the pool, created
+// once by the caller, computes with the tiled method (tile_l2/tile_l1 as for it).
+// Manifest outputs are binary if binary_out; blank lines and lines starting with '#'
+// are skipped. A bad entry is reported and skipped. Returns 0 if every product was
+// written, -1 otherwise.
+int run_batch(const char *manifest, MatrixType type, int binary_out, int tile_l2, int tile_l1,
+              ThreadPool *pool);
+
+#endif
@@ -0,0 +1,296 @@
+#include <stdio.h>   // Standard I/O functions
+#include <stdlib.h>  // Memory management
+#include <string.h>  // String management
+#include <stdint.h>  // int64_t
+#include "chain.h"
+#include "multiply.h"
+
+// Intermediates of one chained product or power. A consumed intermediate goes back
+// to the buffer list, and the next product that fits takes it instead of allocating.
+typedef struct {
+    Matrix *mat;
+    size_t bytes;   // Element buffer it was allocated with
+    int in_use;
+} ChainBuffer;
+
+typedef struct {
+    ThreadPool *pool;
+    int tile_l2, tile_l1;
+    MatrixType type;
+    ChainBuffer *buffers;
+    int num_buffers, capacity;
+    ChainReport *report;   // Never NULL here (a local one when the caller passes none)
+} Chain;
+
+static void init_chain(Chain *ch, ThreadPool *pool, MatrixType type, int tile_l2, int tile_l1,
+                       ChainReport *report) {
+
+    memset(ch, 0, sizeof(*ch));
+    ch->pool = pool;
+    ch->type = type;
+    ch->tile_l2 = tile_l2;
+    ch->tile_l1 = tile_l1;
+    ch->report = report;
+    memset(report, 0, sizeof(*report));
+}
+
+//------------------------------
+// Buffer Recycling
+//------------------------------
+
+// Smallest free buffer that holds rows x cols, reshaped to it; a new one if none does
+static Matrix *acquire(Chain *ch, int rows, int cols) {
+
+    const size_t need = matrix_bytes(rows, cols, ch->type);
+    ChainBuffer *best = NULL;
+    for (int b = 0; b < ch->num_buffers; b++) 
+    {
+        ChainBuffer *buf = &ch->buffers[b];
+        if (!buf->in_use && buf->bytes >= need && (!best || buf->bytes < best->bytes)) best = buf;
+    }
+    if (best) 
+    {
+        best->in_use = 1;
+        reshape_matrix(best->mat, rows, cols);
+        return best->mat;
+    }
+
+    if (ch->num_buffers == ch->capacity) 
+    {
+        ch->capacity = ch->capacity ? ch->capacity * 2 : 4;
+        ChainBuffer *bigger = realloc(ch->buffers, (size_t)ch->capacity * sizeof(ChainBuffer));
+        if (!bigger) 
+        {
+            perror("realloc");
+            exit(EXIT_FAILURE);
+        }
+        ch->buffers = bigger;
+    }
+    ChainBuffer *buf = &ch->buffers[ch->num_buffers++];
+    buf->mat = allocate_matrix(rows, cols, ch->type); // The tiles write every element of C
+    buf->bytes = need;
+    buf->in_use = 1;
+    ch->report->buffers++;
+    return buf->mat;
+}
+
+static void release(Chain *ch, Matrix *mat) {
+
+    for (int b = 0; b < ch->num_buffers; b++) 
+    {
+        if (ch->buffers[b].mat == mat) ch->buffers[b].in_use = 0;
+    }
+}
+
+// Frees every buffer but the result
+static void finish_chain(Chain *ch, Matrix *keep) {
+
+    for (int b = 0; b < ch->num_buffers; b++) 
+    {
+        if (ch->buffers[b].mat != keep) free_matrix(ch->buffers[b].mat);
+    }
+    free(ch->buffers);
+}
+
+//------------------------------
+// Steps
+//------------------------------
+
+static Matrix *product(Chain *ch, Matrix *A, Matrix *B) {
+
+    Matrix *C = acquire(ch, A->rows, B->cols);
+    TileMultArgs args = { A, B, C, ch->tile_l2, ch->tile_l1 };
+    submit_per_tile(ch->pool, &args);
+    pool_wait(ch->pool);
+    ch->report->products++;
+    ch->report->multiply_adds += (double)A->rows * A->cols * B->cols;
+    return C;
+}
+
+static Matrix *copy_of(Chain *ch, const Matrix *src) {
+
+    Matrix *dst = acquire(ch, src->rows, src->cols);
+    const size_t elem_size = matrix_type_size(src->type);
+    for (int i = 0; i < src->rows; i++) 
+    {
+        memcpy((char *)dst->data + (size_t)i * dst->stride * elem_size,
+               (const char *)src->data + (size_t)i * src->stride * elem_size, (size_t)src->cols * elem_size);
+    }
+    return dst;
+}
+
+static Matrix *identity(Chain *ch, int n) {
+
+    Matrix *I = acquire(ch, n, n);
+    memset(I->data, 0, matrix_bytes(n, n, ch->type));
+    for (int i = 0; i < n; i++) 
+    {
+        switch (ch->type) 
+        {
+            case MATRIX_INT64:  MAT_ROW_AS(int64_t, I, i)[i] = 1; break;
+            case MATRIX_FLOAT:  MAT_ROW_AS(float, I, i)[i] = 1.0f; break;
+            case MATRIX_DOUBLE: MAT_ROW_AS(double, I, i)[i] = 1.0; break;
+            default:            MAT_ROW(I, i)[i] = 1; break;
+        }
+    }
+    return I;
+}
+
+// Append to the report's order string, keeping it terminated when it fills up
+static void append_order(ChainReport *report, const char *text) {
+
+    size_t len = strlen(report->order);
+    snprintf(report->order + len, sizeof(report->order) - len, "%s", text);
+}
+
+//------------------------------
+// Chained Products
+//------------------------------
+
+// Classic matrix-chain order: M[i] is dims[i] x dims[i + 1]. cost[i * n + j] is the
+// fewest multiply-adds for M[i..j], reached by splitting it into M[i..s] x M[s+1..j]
+// with s = split[i * n + j].
+static void chain_order(const int *dims, int n, double *cost, int *split) {
+
+    for (int i = 0; i < n; i++) cost[i * n + i] = 0;
+    for (int len = 2; len <= n; len++) 
+    {
+        for (int i = 0; i + len - 1 < n; i++) 
+        {
+            const int j = i + len - 1;
+            cost[i * n + j] = -1;
+            for (int s = i; s < j; s++) 
+            {
+                double c = cost[i * n + s] + cost[(s + 1) * n + j] + (double)dims[i] * dims[s + 1] * dims[j + 1];
+                if (cost[i * n + j] < 0 || c < cost[i * n + j]) 
+                {
+                    cost[i * n + j] = c;
+                    split[i * n + j] = s;
+                }
+            }
+        }
+    }
+}
+
+// M[i..j] as split says; the operands of each product are released as soon as it is done
+static Matrix *evaluate(Chain *ch, Matrix *const *M, const int *split, int n, int i, int j) {
+
+    if (i == j) 
+    {
+        char name[16];
+        snprintf(name, sizeof(name), "%d", i + 1);
+        append_order(ch->report, name);
+        return M[i];
+    }
+    const int s = split[i * n + j];
+    append_order(ch->report, "(");
+    Matrix *L = evaluate(ch, M, split, n, i, s);
+    append_order(ch->report, " ");
+    Matrix *R = evaluate(ch, M, split, n, s + 1, j);
+    append_order(ch->report, ")");
+
+    Matrix *C = product(ch, L, R);
+    if (i != s) release(ch, L);
+    if (s + 1 != j) release(ch, R);
+    return C;
+}
+
+Matrix *multiply_chain(ThreadPool *pool, Matrix *const *M, int n, int tile_l2, int tile_l1, ChainReport *report) {
+
+    for (int i = 0; i + 1 < n; i++) 
+    {
+        if (M[i]->cols != M[i + 1]->rows) 
+        {
+            fprintf(stderr, "Error: Incompatible matrix dimensions for multiplication (matrices %d and %d).\n",
+                    i + 1, i + 2);
+            return NULL;
+        }
+    }
+
+    int *dims = malloc((size_t)(n + 1) * sizeof(int));
+    double *cost = malloc((size_t)n * n * sizeof(double));
+    int *split = calloc((size_t)n * n, sizeof(int));
+    if (!dims || !cost || !split) 
+    {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < n; i++) dims[i] = M[i]->rows;
+    dims[n] = M[n - 1]->cols;
+    chain_order(dims, n, cost, split);
+
+    ChainReport local;
+    Chain ch;
+    init_chain(&ch, pool, M[0]->type, tile_l2, tile_l1, report ? report : &local);
+    Matrix *result = evaluate(&ch, M, split, n, 0, n - 1);
+    if (n == 1) result = copy_of(&ch, result); // The caller owns what it gets back
+    finish_chain(&ch, result);
+
+    free(dims);
+    free(cost);
+    free(split);
+    return result;
+}
+
+//------------------------------
+// Powers
+//------------------------------
+
+// Right-to-left binary exponentiation: base runs through A, A^2, A^4, ... and result
+// picks up the powers matching the set bits of k. A buffer is released once neither
+// variable refers to it.
+Matrix *matrix_power(ThreadPool *pool, Matrix *A, unsigned long long k, int tile_l2, int tile_l1,
+                     ChainReport *report) {
+
+    if (A->rows != A->cols) 
+    {
+        fprintf(stderr, "Error: only a square matrix can be raised to a power (got %dx%d).\n", A->rows, A->cols);
+        return NULL;
+    }
+
+    ChainReport local;
+    Chain ch;
+    init_chain(&ch, pool, A->type, tile_l2, tile_l1, report ? report : &local);
+    snprintf(ch.report->order, sizeof(ch.report->order), "A^%llu =", k);
+
+    Matrix *result = NULL, *base = A;   // NULL result: the identity so far
+    unsigned long long power = 1;       // base is A^power
+    while (k) 
+    {
+        if (k & 1) 
+        {
+            char term[32];
+            snprintf(term, sizeof(term), " A^%llu", power);
+            append_order(ch.report, term);
+            if (!result) 
+            {
+                result = base;
+            }
+            else 
+            {
+                Matrix *next = product(&ch, result, base);
+                if (result != A) release(&ch, result);
+                result = next;
+            }
+        }
+        k >>= 1;
+        if (!k) break;
+
+        Matrix *square = product(&ch, base, base);
+        if (base != A && base != result) release(&ch, base);
+        base = square;
+        power *= 2;
+    }
+
+    if (!result) 
+    {
+        append_order(ch.report, " I");
+        result = identity(&ch, A->rows);
+    }
+    else if (result == A) 
+    {
+        result = copy_of(&ch, A);
+    }
+    finish_chain(&ch, result);
+    return result;
+}
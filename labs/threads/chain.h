@@ -0,0 +1,28 @@
+#ifndef CHAIN_H
+#define CHAIN_H
+
+#include "matrix.h"
+#include "pool.h"
+
+// What a chained product or power did
+typedef struct {
+    char order[256];        // Parenthesisation evaluated, e.g. "((1 2) 3)" (cut short if longer)
+    double multiply_adds;   // Scalar multiply-adds of that order
+    int products;           // Matrix products computed
+    int buffers;            // Intermediate buffers allocated; every other product reused one
+} ChainReport;
+
+// M[0] x M[1] x ... x M[n-1] in the cheapest order, found by dynamic programming over
+// the shapes. Each product runs on the pool with the tiled method (tile_l2/tile_l1 as
+// for it); intermediates stay in memory and their buffers are recycled once consumed.
+// The inputs must share one element type. Returns a new matrix, or NULL (after a
+// message) when neighbouring shapes do not match. report may be NULL.
+Matrix *multiply_chain(ThreadPool *pool, Matrix *const *M, int n, int tile_l2, int tile_l1, ChainReport *report);
+
+// A^k of a square matrix by repeated squaring: about 2*log2(k) products in at most
+// three buffers. A^0 is the identity. Returns a new matrix, or NULL (after a message)
+// when A is not square. report may be NULL.
+Matrix *matrix_power(ThreadPool *pool, Matrix *A, unsigned long long k, int tile_l2, int tile_l1,
+                     ChainReport *report);
+
+#endif
@@ -0,0 +1,133 @@
+#include <stdio.h>   // Standard I/O functions
+#include <stdlib.h>  // Memory management
+#include <string.h>  // memset(), strerror()
+#include <errno.h>   // Why perf_event_open() failed
+#include <unistd.h>  // syscall(), read(), close()
+#include <sys/syscall.h>        // SYS_perf_event_open
+#include <linux/perf_event.h>   // struct perf_event_attr
+#include "counters.h"
+
+#define CACHE_READ_MISS(cache) \
+    ((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+static const struct {
+    const char *name;
+    uint32_t type;
+    uint64_t config;
+} events[COUNTER_COUNT] = {
+    { "cycles",       PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { "instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { "l1d_misses",   PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_L1D) },
+    { "llc_misses",   PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_LL) },
+    { "dtlb_misses",  PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_DTLB) },
+};
+
+const char *counter_name(int event) {
+
+    return events[event].name;
+}
+
+typedef struct {
+    WorkerCounters *wc;
+    int *errors;   // errno of each failed open, num_workers x COUNTER_COUNT
+} OpenJob;
+
+// Runs on each worker: counters for the calling thread only, on any CPU
+static void open_on_worker(void *arg, size_t worker) {
+
+    OpenJob *job = (OpenJob *)arg;
+    for (int e = 0; e < COUNTER_COUNT; e++) 
+    {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = events[e].type;
+        attr.config = events[e].config;
+        attr.exclude_kernel = 1;   // Allowed at perf_event_paranoid 2
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        const size_t slot = worker * COUNTER_COUNT + e;
+        job->wc->fds[slot] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        job->errors[slot] = job->wc->fds[slot] < 0 ? errno : 0;
+    }
+}
+
+WorkerCounters *open_worker_counters(ThreadPool *pool) {
+
+    WorkerCounters *wc = calloc(1, sizeof(WorkerCounters));
+    int *errors = calloc(pool->num_workers * COUNTER_COUNT, sizeof(int));
+    if (wc) 
+    {
+        wc->num_workers = pool->num_workers;
+        wc->fds = malloc(pool->num_workers * COUNTER_COUNT * sizeof(int));
+    }
+    if (!wc || !errors || !wc->fds) 
+    {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+
+    OpenJob job = { wc, errors };
+    pool_run_on_each(pool, open_on_worker, &job);
+
+    // An event is reported only when every worker counts it
+    int any = 0, first_error = 0;
+    for (int e = 0; e < COUNTER_COUNT; e++) 
+    {
+        wc->available[e] = 1;
+        for (size_t w = 0; w < wc->num_workers; w++) 
+        {
+            const int err = errors[w * COUNTER_COUNT + e];
+            if (err && !first_error) first_error = err;
+            if (err) wc->available[e] = 0;
+        }
+        if (!wc->available[e]) 
+        {
+            for (size_t w = 0; w < wc->num_workers; w++) 
+            {
+                int *fd = &wc->fds[w * COUNTER_COUNT + e];
+                if (*fd >= 0) close(*fd);
+                *fd = -1;
+            }
+        }
+        any |= wc->available[e];
+    }
+    free(errors);
+
+    if (!any) 
+    {
+        fprintf(stderr, "Warning: no hardware counters available (perf_event_open: %s)\n", strerror(first_error));
+        close_worker_counters(wc);
+        return NULL;
+    }
+    for (int e = 0; e < COUNTER_COUNT; e++) 
+    {
+        if (!wc->available[e]) fprintf(stderr, "Warning: %s cannot be counted here\n", events[e].name);
+    }
+    return wc;
+}
+
+void read_worker_counters(const WorkerCounters *wc, uint64_t *out) {
+
+    for (size_t slot = 0; slot < wc->num_workers * COUNTER_COUNT; slot++) 
+    {
+        uint64_t v[3]; // value, time enabled, time running
+        out[slot] = 0;
+        if (wc->fds[slot] < 0 || read(wc->fds[slot], v, sizeof(v)) != sizeof(v)) continue;
+
+        // Multiplexed with other events: extrapolate to the whole enabled time
+        out[slot] = v[2] > 0 && v[2] < v[1] ? (uint64_t)((double)v[0] * v[1] / v[2]) : v[0];
+    }
+}
+
+void close_worker_counters(WorkerCounters *wc) {
+
+    if (!wc) return;
+    for (size_t slot = 0; slot < wc->num_workers * COUNTER_COUNT; slot++) 
+    {
+        if (wc->fds[slot] >= 0) close(wc->fds[slot]);
+    }
+    free(wc->fds);
+    free(wc);
+}
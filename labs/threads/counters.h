@@ -0,0 +1,38 @@
+#ifndef COUNTERS_H
+#define COUNTERS_H
+
+#include <stdint.h>
+#include "pool.h"
+
+// Hardware events counted on every worker thread (user-space only)
+enum {
+    COUNTER_CYCLES,
+    COUNTER_INSTRUCTIONS,
+    COUNTER_L1D_MISSES,    // L1 data cache read misses
+    COUNTER_LLC_MISSES,    // Last-level cache read misses
+    COUNTER_DTLB_MISSES,   // Data TLB read misses
+    COUNTER_COUNT
+};
+
+// Per-thread perf_event_open() counters for all workers of a pool
+typedef struct {
+    size_t num_workers;
+    int *fds;                         // num_workers x COUNTER_COUNT, -1 where not counted
+    int available[COUNTER_COUNT];     // Event could be opened on every worker
+} WorkerCounters;
+
+// Function prototypes
+const char *counter_name(int event);  // "cycles", "instructions", "l1d_misses", "llc_misses", "dtlb_misses"
+
+// Opens the counters on each worker of the pool (call with the pool idle). Events the
+// CPU, kernel or perf_event_paranoid setting refuse are left out; returns NULL, after a
+// warning, when none of them can be counted.
+WorkerCounters *open_worker_counters(ThreadPool *pool);
+
+// Running totals so far, scaled for multiplexing: out[w * COUNTER_COUNT + event]
+// (0 for unavailable events). Subtract two readings to count a stretch of work.
+void read_worker_counters(const WorkerCounters *wc, uint64_t *out);
+
+void close_worker_counters(WorkerCounters *wc);
+
+#endif
@@ -0,0 +1,416 @@
+#include <stdio.h>    // Standard I/O functions
+#include <string.h>   // strcmp()
+#include <stdint.h>   // INT32_MAX
+#include <pthread.h>  // pthread_once()
+#include <immintrin.h> // AVX2 / AVX-512 intrinsics
+#include "kernels.h"
+
+//------------------------------
+// Scalar Kernels
+//------------------------------
+
+static int dot_scalar(const int *a, const int *b, size_t stride, int depth) {
+
+    unsigned sum = 0; // Unsigned so overflow wraps exactly like the vector lanes
+    for (int k = 0; k < depth; k++, b += stride) 
+    {
+        sum += (unsigned)a[k] * (unsigned)*b;
+    }
+    return (int)sum;
+}
+
+static void row_scalar(const int *a, const int *b, size_t stride, int *c, int n, int depth) {
+
+    for (int j = 0; j < n; j++) 
+    {
+        c[j] = dot_scalar(a, b + j, stride, depth);
+    }
+}
+
+static void row_packed_scalar(const int *a, const int *bt, size_t stride, int *c, int n, int depth) {
+
+    for (int j = 0; j < n; j++, bt += stride) 
+    {
+        c[j] = dot_scalar(a, bt, 1, depth);
+    }
+}
+
+static void axpy_scalar(int *c, int scale, const int *b, int n) {
+
+    for (int j = 0; j < n; j++) 
+    {
+        c[j] = (int)((unsigned)c[j] + (unsigned)scale * (unsigned)b[j]);
+    }
+}
+
+//------------------------------
+// AVX2 Kernels (8 lanes)
+//------------------------------
+
+__attribute__((target("avx2")))
+static int hsum_avx2(__m256i v) {
+
+    __m128i s = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 3, 2)));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(s);
+}
+
+// Column walk of B: unit stride uses plain loads, otherwise a gather of 8 rows
+__attribute__((target("avx2")))
+static int dot_avx2(const int *a, const int *b, size_t stride, int depth) {
+
+    if (stride > INT32_MAX / 8) // Gather offsets are 32-bit
+    {
+        return dot_scalar(a, b, stride, depth);
+    }
+
+    __m256i acc = _mm256_setzero_si256();
+    int k = 0;
+    if (stride == 1) 
+    {
+        for (; k + 8 <= depth; k += 8) 
+        {
+            __m256i va = _mm256_loadu_si256((const __m256i *)(a + k));
+            __m256i vb = _mm256_loadu_si256((const __m256i *)(b + k));
+            acc = _mm256_add_epi32(acc, _mm256_mullo_epi32(va, vb));
+        }
+    } 
+    else 
+    {
+        const int s = (int)stride;
+        const __m256i offsets = _mm256_setr_epi32(0, s, 2 * s, 3 * s, 4 * s, 5 * s, 6 * s, 7 * s);
+        for (; k + 8 <= depth; k += 8) 
+        {
+            __m256i va = _mm256_loadu_si256((const __m256i *)(a + k));
+            __m256i vb = _mm256_i32gather_epi32(b + (size_t)k * stride, offsets, 4);
+            acc = _mm256_add_epi32(acc, _mm256_mullo_epi32(va, vb));
+        }
+    }
+    unsigned sum = (unsigned)hsum_avx2(acc);
+    return (int)(sum + (unsigned)dot_scalar(a + k, b + (size_t)k * stride, stride, depth - k));
+}
+
+// Register-blocked: 32 columns of C are accumulated in 4 registers across all of k
+__attribute__((target("avx2")))
+static void row_avx2(const int *a, const int *b, size_t stride, int *c, int n, int depth) {
+
+    int j = 0;
+    for (; j + 32 <= n; j += 32) 
+    {
+        __m256i c0 = _mm256_setzero_si256(), c1 = _mm256_setzero_si256();
+        __m256i c2 = _mm256_setzero_si256(), c3 = _mm256_setzero_si256();
+        const int *bk = b + j;
+        for (int k = 0; k < depth; k++, bk += stride) 
+        {
+            __m256i va = _mm256_set1_epi32(a[k]);
+            c0 = _mm256_add_epi32(c0, _mm256_mullo_epi32(va, _mm256_loadu_si256((const __m256i *)(bk + 0))));
+            c1 = _mm256_add_epi32(c1, _mm256_mullo_epi32(va, _mm256_loadu_si256((const __m256i *)(bk + 8))));
+            c2 = _mm256_add_epi32(c2, _mm256_mullo_epi32(va, _mm256_loadu_si256((const __m256i *)(bk + 16))));
+            c3 = _mm256_add_epi32(c3, _mm256_mullo_epi32(va, _mm256_loadu_si256((const __m256i *)(bk + 24))));
+        }
+        _mm256_storeu_si256((__m256i *)(c + j + 0), c0);
+        _mm256_storeu_si256((__m256i *)(c + j + 8), c1);
+        _mm256_storeu_si256((__m256i *)(c + j + 16), c2);
+        _mm256_storeu_si256((__m256i *)(c + j + 24), c3);
+    }
+    for (; j + 8 <= n; j += 8) 
+    {
+        __m256i c0 = _mm256_setzero_si256();
+        const int *bk = b + j;
+        for (int k = 0; k < depth; k++, bk += stride) 
+        {
+            c0 = _mm256_add_epi32(c0, _mm256_mullo_epi32(_mm256_set1_epi32(a[k]), _mm256_loadu_si256((const __m256i *)bk)));
+        }
+        _mm256_storeu_si256((__m256i *)(c + j), c0);
+    }
+    row_scalar(a, b + j, stride, c + j, n - j, depth); // Leftover columns
+}
+
+// Four columns of B^T at a time, so each load of a feeds four products
+__attribute__((target("avx2")))
+static void row_packed_avx2(const int *a, const int *bt, size_t stride, int *c, int n, int depth) {
+
+    int j = 0;
+    for (; j + 4 <= n; j += 4) 
+    {
+        const int *b0 = bt + (size_t)j * stride, *b1 = b0 + stride, *b2 = b1 + stride, *b3 = b2 + stride;
+        __m256i s0 = _mm256_setzero_si256(), s1 = _mm256_setzero_si256();
+        __m256i s2 = _mm256_setzero_si256(), s3 = _mm256_setzero_si256();
+        int k = 0;
+        for (; k + 8 <= depth; k += 8) 
+        {
+            __m256i va = _mm256_loadu_si256((const __m256i *)(a + k));
+            s0 = _mm256_add_epi32(s0, _mm256_mullo_epi32(va, _mm256_loadu_si256((const __m256i *)(b0 + k))));
+            s1 = _mm256_add_epi32(s1, _mm256_mullo_epi32(va, _mm256_loadu_si256((const __m256i *)(b1 + k))));
+            s2 = _mm256_add_epi32(s2, _mm256_mullo_epi32(va, _mm256_loadu_si256((const __m256i *)(b2 + k))));
+            s3 = _mm256_add_epi32(s3, _mm256_mullo_epi32(va, _mm256_loadu_si256((const __m256i *)(b3 + k))));
+        }
+        c[j + 0] = (int)((unsigned)hsum_avx2(s0) + (unsigned)dot_scalar(a + k, b0 + k, 1, depth - k));
+        c[j + 1] = (int)((unsigned)hsum_avx2(s1) + (unsigned)dot_scalar(a + k, b1 + k, 1, depth - k));
+        c[j + 2] = (int)((unsigned)hsum_avx2(s2) + (unsigned)dot_scalar(a + k, b2 + k, 1, depth - k));
+        c[j + 3] = (int)((unsigned)hsum_avx2(s3) + (unsigned)dot_scalar(a + k, b3 + k, 1, depth - k));
+    }
+    for (; j < n; j++) 
+    {
+        c[j] = dot_avx2(a, bt + (size_t)j * stride, 1, depth);
+    }
+}
+
+__attribute__((target("avx2")))
+static void axpy_avx2(int *c, int scale, const int *b, int n) {
+
+    const __m256i vs = _mm256_set1_epi32(scale);
+    int j = 0;
+    for (; j + 8 <= n; j += 8) 
+    {
+        __m256i vc = _mm256_loadu_si256((const __m256i *)(c + j));
+        __m256i vb = _mm256_loadu_si256((const __m256i *)(b + j));
+        _mm256_storeu_si256((__m256i *)(c + j), _mm256_add_epi32(vc, _mm256_mullo_epi32(vs, vb)));
+    }
+    axpy_scalar(c + j, scale, b + j, n - j);
+}
+
+//------------------------------
+// AVX-512 Kernels (16 lanes, masked tails)
+//------------------------------
+
+__attribute__((target("avx512f")))
+static int dot_avx512(const int *a, const int *b, size_t stride, int depth) {
+
+    if (stride > INT32_MAX / 16) // Gather offsets are 32-bit
+    {
+        return dot_scalar(a, b, stride, depth);
+    }
+
+    __m512i acc = _mm512_setzero_si512();
+    int k = 0;
+    if (stride == 1) 
+    {
+        for (; k < depth; k += 16) 
+        {
+            __mmask16 m = depth - k >= 16 ? 0xFFFF : (__mmask16)((1u << (depth - k)) - 1);
+            __m512i va = _mm512_maskz_loadu_epi32(m, a + k);
+            __m512i vb = _mm512_maskz_loadu_epi32(m, b + k);
+            acc = _mm512_add_epi32(acc, _mm512_mullo_epi32(va, vb));
+        }
+    } 
+    else 
+    {
+        const __m512i offsets = _mm512_mullo_epi32(_mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15),
+                                                   _mm512_set1_epi32((int)stride));
+        for (; k < depth; k += 16) 
+        {
+            __mmask16 m = depth - k >= 16 ? 0xFFFF : (__mmask16)((1u << (depth - k)) - 1);
+            __m512i va = _mm512_maskz_loadu_epi32(m, a + k);
+            __m512i vb = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), m, offsets, b + (size_t)k * stride, 4);
+            acc = _mm512_add_epi32(acc, _mm512_mullo_epi32(va, vb));
+        }
+    }
+    return _mm512_reduce_add_epi32(acc);
+}
+
+// Register-blocked: 64 columns of C are accumulated in 4 registers across all of k
+__attribute__((target("avx512f")))
+static void row_avx512(const int *a, const int *b, size_t stride, int *c, int n, int depth) {
+
+    int j = 0;
+    for (; j + 64 <= n; j += 64) 
+    {
+        __m512i c0 = _mm512_setzero_si512(), c1 = _mm512_setzero_si512();
+        __m512i c2 = _mm512_setzero_si512(), c3 = _mm512_setzero_si512();
+        const int *bk = b + j;
+        for (int k = 0; k < depth; k++, bk += stride) 
+        {
+            __m512i va = _mm512_set1_epi32(a[k]);
+            c0 = _mm512_add_epi32(c0, _mm512_mullo_epi32(va, _mm512_loadu_si512(bk + 0)));
+            c1 = _mm512_add_epi32(c1, _mm512_mullo_epi32(va, _mm512_loadu_si512(bk + 16)));
+            c2 = _mm512_add_epi32(c2, _mm512_mullo_epi32(va, _mm512_loadu_si512(bk + 32)));
+            c3 = _mm512_add_epi32(c3, _mm512_mullo_epi32(va, _mm512_loadu_si512(bk + 48)));
+        }
+        _mm512_storeu_si512(c + j + 0, c0);
+        _mm512_storeu_si512(c + j + 16, c1);
+        _mm512_storeu_si512(c + j + 32, c2);
+        _mm512_storeu_si512(c + j + 48, c3);
+    }
+    for (; j < n; j += 16) 
+    {
+        __mmask16 m = n - j >= 16 ? 0xFFFF : (__mmask16)((1u << (n - j)) - 1);
+        __m512i c0 = _mm512_setzero_si512();
+        const int *bk = b + j;
+        for (int k = 0; k < depth; k++, bk += stride) 
+        {
+            c0 = _mm512_add_epi32(c0, _mm512_mullo_epi32(_mm512_set1_epi32(a[k]), _mm512_maskz_loadu_epi32(m, bk)));
+        }
+        _mm512_mask_storeu_epi32(c + j, m, c0);
+    }
+}
+
+// Four columns of B^T at a time, so each load of a feeds four products
+__attribute__((target("avx512f")))
+static void row_packed_avx512(const int *a, const int *bt, size_t stride, int *c, int n, int depth) {
+
+    int j = 0;
+    for (; j + 4 <= n; j += 4) 
+    {
+        const int *b0 = bt + (size_t)j * stride, *b1 = b0 + stride, *b2 = b1 + stride, *b3 = b2 + stride;
+        __m512i s0 = _mm512_setzero_si512(), s1 = _mm512_setzero_si512();
+        __m512i s2 = _mm512_setzero_si512(), s3 = _mm512_setzero_si512();
+        for (int k = 0; k < depth; k += 16) 
+        {
+            __mmask16 m = depth - k >= 16 ? 0xFFFF : (__mmask16)((1u << (depth - k)) - 1);
+            __m512i va = _mm512_maskz_loadu_epi32(m, a + k);
+            s0 = _mm512_add_epi32(s0, _mm512_mullo_epi32(va, _mm512_maskz_loadu_epi32(m, b0 + k)));
+            s1 = _mm512_add_epi32(s1, _mm512_mullo_epi32(va, _mm512_maskz_loadu_epi32(m, b1 + k)));
+            s2 = _mm512_add_epi32(s2, _mm512_mullo_epi32(va, _mm512_maskz_loadu_epi32(m, b2 + k)));
+            s3 = _mm512_add_epi32(s3, _mm512_mullo_epi32(va, _mm512_maskz_loadu_epi32(m, b3 + k)));
+        }
+        c[j + 0] = _mm512_reduce_add_epi32(s0);
+        c[j + 1] = _mm512_reduce_add_epi32(s1);
+        c[j + 2] = _mm512_reduce_add_epi32(s2);
+        c[j + 3] = _mm512_reduce_add_epi32(s3);
+    }
+    for (; j < n; j++) 
+    {
+        c[j] = dot_avx512(a, bt + (size_t)j * stride, 1, depth);
+    }
+}
+
+__attribute__((target("avx512f")))
+static void axpy_avx512(int *c, int scale, const int *b, int n) {
+
+    const __m512i vs = _mm512_set1_epi32(scale);
+    for (int j = 0; j < n; j += 16) 
+    {
+        __mmask16 m = n - j >= 16 ? 0xFFFF : (__mmask16)((1u << (n - j)) - 1);
+        __m512i vc = _mm512_maskz_loadu_epi32(m, c + j);
+        __m512i vb = _mm512_maskz_loadu_epi32(m, b + j);
+        _mm512_mask_storeu_epi32(c + j, m, _mm512_add_epi32(vc, _mm512_mullo_epi32(vs, vb)));
+    }
+}
+
+//------------------------------
+// Typed Kernels (int64, float, double)
+//------------------------------
+
+// Plain loops compiled once per instruction set: lanes run across j, so the
+// compiler vectorises them without reordering any element's sum over k
+// (floating-point contraction is disabled in the Makefile for the same reason).
+#define TYPED_ROW_CHUNK 64
+
+#define DEFINE_TYPED_KERNELS(T, ACC, suffix, attr)                                            \
+    attr static T dot_##suffix(const T *a, const T *b, size_t stride, int depth) {            \
+        ACC sum = 0;                                                                          \
+        for (int k = 0; k < depth; k++, b += stride) sum += (ACC)a[k] * (ACC)*b;              \
+        return (T)sum;                                                                        \
+    }                                                                                         \
+    attr static void row_##suffix(const T *a, const T *b, size_t stride, T *c, int n, int depth) { \
+        ACC acc[TYPED_ROW_CHUNK];                                                             \
+        for (int j0 = 0; j0 < n; j0 += TYPED_ROW_CHUNK)                                       \
+        {                                                                                     \
+            const int len = n - j0 < TYPED_ROW_CHUNK ? n - j0 : TYPED_ROW_CHUNK;              \
+            const T *bk = b + j0;                                                             \
+            for (int j = 0; j < len; j++) acc[j] = 0;                                         \
+            for (int k = 0; k < depth; k++, bk += stride)                                     \
+            {                                                                                 \
+                const ACC ak = (ACC)a[k];                                                     \
+                for (int j = 0; j < len; j++) acc[j] += ak * (ACC)bk[j];                      \
+            }                                                                                 \
+            for (int j = 0; j < len; j++) c[j0 + j] = (T)acc[j];                              \
+        }                                                                                     \
+    }                                                                                         \
+    attr static void axpy_##suffix(ACC *acc, T scale, const T *b, int n) {                    \
+        const ACC s = (ACC)scale;                                                             \
+        for (int j = 0; j < n; j++) acc[j] += s * (ACC)b[j];                                  \
+    }
+
+#define AVX2_TARGET   __attribute__((target("avx2")))
+#define AVX512_TARGET __attribute__((target("avx512f")))
+
+DEFINE_TYPED_KERNELS(int64_t, uint64_t, i64_scalar, )
+DEFINE_TYPED_KERNELS(int64_t, uint64_t, i64_avx2, AVX2_TARGET)
+DEFINE_TYPED_KERNELS(int64_t, uint64_t, i64_avx512, AVX512_TARGET)
+DEFINE_TYPED_KERNELS(float, double, f32_scalar, )
+DEFINE_TYPED_KERNELS(float, double, f32_avx2, AVX2_TARGET)
+DEFINE_TYPED_KERNELS(float, double, f32_avx512, AVX512_TARGET)
+DEFINE_TYPED_KERNELS(double, double, f64_scalar, )
+DEFINE_TYPED_KERNELS(double, double, f64_avx2, AVX2_TARGET)
+DEFINE_TYPED_KERNELS(double, double, f64_avx512, AVX512_TARGET)
+
+#define TYPED_ENTRIES(isa) \
+    { dot_i64_##isa, row_i64_##isa, axpy_i64_##isa }, \
+    { dot_f32_##isa, row_f32_##isa, axpy_f32_##isa }, \
+    { dot_f64_##isa, row_f64_##isa, axpy_f64_##isa }
+
+//------------------------------
+// Runtime Dispatch
+//------------------------------
+
+static const Kernels kernel_table[] = {
+    { "avx512", dot_avx512, row_avx512, row_packed_avx512, axpy_avx512, TYPED_ENTRIES(avx512) },
+    { "avx2",   dot_avx2,   row_avx2,   row_packed_avx2,   axpy_avx2,   TYPED_ENTRIES(avx2) },
+    { "scalar", dot_scalar, row_scalar, row_packed_scalar, axpy_scalar, TYPED_ENTRIES(scalar) },
+};
+
+static const Kernels *active_kernels;
+static pthread_once_t kernels_once = PTHREAD_ONCE_INIT;
+
+// Whether this CPU (and OS) can run the given table entry
+static int kernels_supported(const Kernels *k) {
+
+    __builtin_cpu_init();
+    if (strcmp(k->name, "avx512") == 0) return __builtin_cpu_supports("avx512f");
+    if (strcmp(k->name, "avx2") == 0)   return __builtin_cpu_supports("avx2");
+    return 1;
+}
+
+// First (widest) entry the CPU supports; scalar always qualifies
+static void detect_kernels(void) {
+
+    for (size_t t = 0; t < sizeof(kernel_table) / sizeof(kernel_table[0]); t++) 
+    {
+        if (kernels_supported(&kernel_table[t])) 
+        {
+            active_kernels = &kernel_table[t];
+            return;
+        }
+    }
+}
+
+const Kernels *get_kernels(void) {
+
+    pthread_once(&kernels_once, detect_kernels);
+    return active_kernels;
+}
+
+// Names of the kernel sets this CPU can run, widest first; returns how many
+size_t available_kernels(const char **names, size_t max) {
+
+    size_t count = 0;
+    for (size_t t = 0; t < sizeof(kernel_table) / sizeof(kernel_table[0]) && count < max; t++) 
+    {
+        if (kernels_supported(&kernel_table[t])) names[count++] = kernel_table[t].name;
+    }
+    return count;
+}
+
+// Override the automatic choice; refuses kernels the CPU cannot run
+int select_kernels(const char *name) {
+
+    pthread_once(&kernels_once, detect_kernels);
+    for (size_t t = 0; t < sizeof(kernel_table) / sizeof(kernel_table[0]); t++) 
+    {
+        if (strcmp(kernel_table[t].name, name) == 0) 
+        {
+            if (!kernels_supported(&kernel_table[t])) 
+            {
+                fprintf(stderr, "Error: this CPU does not support the %s kernels\n", name);
+                return -1;
+            }
+            active_kernels = &kernel_table[t];
+            return 0;
+        }
+    }
+    fprintf(stderr, "Error: unknown kernel set '%s' (expected avx512, avx2 or scalar)\n", name);
+    return -1;
+}
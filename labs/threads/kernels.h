@@ -0,0 +1,52 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Kernels for the wider element types. Each accumulates in ACC (uint64_t for int64,
+// so overflow wraps modulo 2^64; double for float and double) and adds the products
+// of every output element in ascending k, so all methods and instruction sets agree
+// to the last bit. Vector lanes run across output columns, never across k.
+#define DECLARE_TYPED_KERNELS(T, ACC, Name)                                                   \
+    typedef struct {                                                                          \
+        T (*dot)(const T *a, const T *b, size_t stride, int depth);                           \
+        void (*row)(const T *a, const T *b, size_t stride, T *c, int n, int depth);           \
+        void (*axpy)(ACC *acc, T scale, const T *b, int n);  /* acc[0..n) += scale * b */     \
+    } Name;
+
+DECLARE_TYPED_KERNELS(int64_t, uint64_t, KernelsI64)
+DECLARE_TYPED_KERNELS(float, double, KernelsF32)
+DECLARE_TYPED_KERNELS(double, double, KernelsF64)
+
+// Inner loops of the multiply methods, one implementation per instruction set.
+// The int variants use 32-bit wrap-around arithmetic; integer addition modulo 2^32
+// does not depend on summation order, so every kernel gives bit-identical results.
+typedef struct {
+    const char *name;
+
+    // Dot product of a[0..depth) with b[0], b[stride], b[2*stride], ...
+    int (*dot)(const int *a, const int *b, size_t stride, int depth);
+
+    // c[0..n) = sum over k < depth of a[k] * b[k*stride + 0..n)
+    void (*row)(const int *a, const int *b, size_t stride, int *c, int n, int depth);
+
+    // c[j] = dot of a[0..depth) with bt[j*stride + 0..depth) for j < n
+    // (row of C against a transposed B: both operands are read with unit stride)
+    void (*row_packed)(const int *a, const int *bt, size_t stride, int *c, int n, int depth);
+
+    // c[0..n) += scale * b[0..n)
+    void (*axpy)(int *c, int scale, const int *b, int n);
+
+    // Same instruction set for the other element types
+    KernelsI64 i64;
+    KernelsF32 f32;
+    KernelsF64 f64;
+} Kernels;
+
+// Function prototypes
+const Kernels *get_kernels(void);             // Best kernels for this CPU (chosen once)
+int select_kernels(const char *name);         // Force "scalar", "avx2" or "avx512"; 0 on success
+size_t available_kernels(const char **names, size_t max);  // Sets this CPU supports, widest first
+
+#endif
@@ -0,0 +1,88 @@
+#include <stdio.h>   // Standard I/O functions
+#include <stdlib.h>  // Exit codes
+#include <string.h>  // String management
+#include "matrix.h"  // Matrix storage and file I/O
+
+//------------------------------
+// Text <-> binary matrix file converter
+//------------------------------
+// The input format is detected from the file contents; the output format follows the
+// output name: ".bin" writes the binary format, ".coo" the sparse "i j value" text
+// format (nonzeros only), anything else dense text. Elements are int32 unless an
+// optional leading --type=int64|float|double says otherwise (sparse output is int32 only).
+// Nonzeros of mat in row-major order, as a sparse file
+static int write_sparse(const char *filename, const Matrix *mat) {
+
+    size_t count = 0;
+    for (int i = 0; i < mat->rows; i++) 
+    {
+        for (int j = 0; j < mat->cols; j++) count += (MAT_ROW(mat, i)[j] != 0);
+    }
+    MatrixEntry *entries = malloc((count + 1) * sizeof(MatrixEntry));
+    count = 0;
+    if (!entries) 
+    {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < mat->rows; i++) 
+    {
+        for (int j = 0; j < mat->cols; j++) 
+        {
+            if (MAT_ROW(mat, i)[j] != 0) entries[count++] = (MatrixEntry){ i, j, MAT_ROW(mat, i)[j] };
+        }
+    }
+    int status = write_matrix_entries(filename, mat->rows, mat->cols, entries, count);
+    free(entries);
+    return status;
+}
+
+int main(int argc, char *argv[]) 
+{
+    MatrixType type = MATRIX_INT32;
+    if (argc == 4 && strncmp(argv[1], "--type=", 7) == 0) 
+    {
+        if (parse_matrix_type(argv[1] + 7, &type) != 0) return EXIT_FAILURE;
+        argv++;
+        argc--;
+    }
+    if (argc != 3) 
+    {
+        fprintf(stderr, "Usage: %s [--type=TYPE] input output(.txt|.bin|.coo)\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const char *ext = strrchr(argv[2], '.');
+    if (type != MATRIX_INT32 && ext && strcmp(ext, ".coo") == 0) 
+    {
+        fprintf(stderr, "Error: sparse output only supports int32 elements.\n");
+        return EXIT_FAILURE;
+    }
+
+    ThreadPool *pool = create_pool(0); // Parses and formats large text files in parallel
+    Matrix *mat = read_matrix_as(argv[1], type, pool);
+    if (!mat) 
+    {
+        fprintf(stderr, "Error reading %s.\n", argv[1]);
+        free_pool(pool);
+        return EXIT_FAILURE;
+    }
+
+    int status = 0;
+    if (ext && strcmp(ext, ".bin") == 0) 
+    {
+        status = write_matrix_binary(argv[2], mat);
+    }
+    else if (ext && strcmp(ext, ".coo") == 0) 
+    {
+        status = write_sparse(argv[2], mat);
+    }
+    else 
+    {
+        status = write_matrix_to_file(argv[2], mat, pool);
+    }
+
+    free_pool(pool);
+    free_matrix(mat);
+    return status == 0 ? 0 : EXIT_FAILURE;
+}
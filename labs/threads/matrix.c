@@ -0,0 +1,1749 @@
+#define _GNU_SOURCE  // copy_file_range()
+#include <stdio.h>   // Standard I/O functions
+#include <stdlib.h>  // Memory management
+#include <string.h>  // String management
+#include <fcntl.h>     // open()
+#include <unistd.h>    // read(), close()
+#include <sys/mman.h>  // mmap() for zero-copy input
+#include <sys/stat.h>  // fstat() for the input size
+#include <errno.h>     // EINTR while refilling the text window
+#include <limits.h>    // INT_MAX
+#include <sys/ioctl.h> // ioctl(FICLONE)
+#include <linux/fs.h>  // FICLONE: reflink copies of result files
+#ifdef __SSE2__
+#include <emmintrin.h> // SSE2 byte compares for digit scanning
+#endif
+#include "matrix.h"
+
+static const struct {
+    const char *name;
+    size_t size;
+} matrix_types[] = {
+    [MATRIX_INT32]  = { "int32",  sizeof(int32_t) },
+    [MATRIX_INT64]  = { "int64",  sizeof(int64_t) },
+    [MATRIX_FLOAT]  = { "float",  sizeof(float) },
+    [MATRIX_DOUBLE] = { "double", sizeof(double) },
+};
+
+size_t matrix_type_size(MatrixType type) { return matrix_types[type].size; }
+const char *matrix_type_name(MatrixType type) { return matrix_types[type].name; }
+
+int parse_matrix_type(const char *name, MatrixType *type) {
+
+    for (size_t t = 0; t < sizeof(matrix_types) / sizeof(matrix_types[0]); t++) 
+    {
+        if (strcmp(name, matrix_types[t].name) == 0) 
+        {
+            *type = (MatrixType)t;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+// Row pitch (in elements) for cols elements: whole cache lines, so every row starts aligned
+static int padded_stride(int cols, size_t elem_size) {
+
+    const int per_line = (int)(MATRIX_ALIGN / elem_size);
+    return (cols + per_line - 1) / per_line * per_line;
+}
+
+// Allocate a new int32 matrix with given dimensions; memory is zero‐initialized.
+Matrix *create_matrix(int rows, int cols) {
+
+    return create_matrix_typed(rows, cols, MATRIX_INT32);
+}
+
+// The same for any element type
+Matrix *create_matrix_typed(int rows, int cols, MatrixType type) {
+
+    Matrix *mat = allocate_matrix(rows, cols, type);
+    memset(mat->data, 0, (size_t)rows * mat->stride * matrix_type_size(type)); //Zero the elements and the row padding
+    return mat;
+}
+
+// The Matrix header and the element buffer share a single aligned allocation.
+// Only the header is initialised: the pages of the elements are first touched by
+// whoever writes them, which decides the NUMA node they end up on.
+Matrix *allocate_matrix(int rows, int cols, MatrixType type) {
+
+    // Pad each row up to a whole number of cache lines so every row starts aligned
+    const size_t elem_size = matrix_type_size(type);
+    int stride = padded_stride(cols, elem_size);
+
+    // The header is padded to MATRIX_ALIGN so the data right after it is aligned too
+    size_t header = (sizeof(Matrix) + MATRIX_ALIGN - 1) / MATRIX_ALIGN * MATRIX_ALIGN;
+    size_t bytes = header + (size_t)rows * stride * elem_size; // Already a multiple of MATRIX_ALIGN
+
+    Matrix *mat = aligned_alloc(MATRIX_ALIGN, bytes); //One block for the struct and all the elements
+    if (!mat) 
+    {
+        perror("aligned_alloc");
+        exit(EXIT_FAILURE);
+    }
+    memset(mat, 0, header); //Zero-initialize the header
+
+    //Set the matrix dimensions using the input arguments
+    mat->rows = rows;
+    mat->cols = cols;
+    mat->stride = stride;
+    mat->type = type;
+    mat->data = (int *)((char *)mat + header); //Elements start right after the padded header
+    return mat;
+}
+
+size_t matrix_bytes(int rows, int cols, MatrixType type) {
+
+    const size_t elem_size = matrix_type_size(type);
+    return (size_t)rows * padded_stride(cols, elem_size) * elem_size;
+}
+
+// Only the header changes: the caller has checked that the buffer is large enough
+void reshape_matrix(Matrix *mat, int rows, int cols) {
+
+    mat->rows = rows;
+    mat->cols = cols;
+    mat->stride = padded_stride(cols, matrix_type_size(mat->type));
+}
+
+// Free a matrix created by create_matrix() or loaded from a file
+void free_matrix(Matrix *mat) {
+
+    if (mat && mat->map) // Elements live in a mapped binary file
+    {
+        munmap(mat->map, mat->map_len);
+    }
+    free(mat); // Header and elements were allocated together (free(NULL) is a no-op)
+}
+
+//------------------------------
+// Text Parsing
+//------------------------------
+
+// Whole contents of an input file: mapped (private, copy-on-write) when possible,
+// otherwise read into memory
+typedef struct {
+    char *data;
+    size_t len;
+    int mapped;   // 1 = munmap() on release, 0 = free()
+} FileBuffer;
+
+static int load_file(const char *filename, FileBuffer *fb) {
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) 
+    {
+        perror(filename);  // Print system error message
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) 
+    {
+        fb->len = (size_t)st.st_size;
+        fb->mapped = 1;
+        if (fb->len == 0) // Nothing to map; treated like an empty read below
+        {
+            fb->data = NULL;
+            close(fd);
+            return 0;
+        }
+        void *map = mmap(NULL, fb->len, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) 
+        {
+            madvise(map, fb->len, MADV_SEQUENTIAL); // One front-to-back pass
+            fb->data = map;
+            close(fd);
+            return 0;
+        }
+    }
+
+    // Pipes and other unmappable files: read everything into a growing buffer
+    size_t cap = 1 << 16, len = 0;
+    char *buf = malloc(cap);
+    if (!buf) 
+    {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    ssize_t got;
+    while ((got = read(fd, buf + len, cap - len)) > 0) 
+    {
+        len += (size_t)got;
+        if (len == cap) 
+        {
+            cap *= 2;
+            char *bigger = realloc(buf, cap);
+            if (!bigger) 
+            {
+                perror("realloc");
+                exit(EXIT_FAILURE);
+            }
+            buf = bigger;
+        }
+    }
+    close(fd);
+    if (got < 0) 
+    {
+        perror(filename);
+        free(buf);
+        return -1;
+    }
+    fb->data = buf;
+    fb->len = len;
+    fb->mapped = 0;
+    return 0;
+}
+
+static void release_file(FileBuffer *fb) {
+
+    if (fb->mapped) 
+    {
+        if (fb->data) munmap(fb->data, fb->len);
+    }
+    else 
+    {
+        free(fb->data);
+    }
+}
+
+// Same set of characters that fscanf() skips before a number
+static inline int is_space(char ch) {
+
+    return ch == ' ' || ch == '\n' || ch == '\t' || ch == '\r' || ch == '\v' || ch == '\f';
+}
+
+// Number of leading ASCII digits in p[0..16) (16 means "at least 16").
+// With SSE2 the run is found with one compare over 16 bytes instead of a byte loop.
+static inline int digit_run(const char *p, const char *end) {
+
+#ifdef __SSE2__
+    if (end - p >= 16) 
+    {
+        __m128i bytes = _mm_sub_epi8(_mm_loadu_si128((const __m128i *)p), _mm_set1_epi8('0'));
+        __m128i is_digit = _mm_cmpeq_epi8(_mm_min_epu8(bytes, _mm_set1_epi8(9)), bytes); // (ch - '0') <= 9 unsigned
+        unsigned mask = (unsigned)_mm_movemask_epi8(is_digit);
+        return __builtin_ctz(~mask | 0x10000u);
+    }
+#endif
+    int n = 0;
+    while (p + n < end && n < 16 && (unsigned)(p[n] - '0') <= 9) n++;
+    return n;
+}
+
+// Parse one integer at *pp (after optional whitespace) the way fscanf("%d") would,
+// advancing *pp past it. Returns 0 when no integer is there.
+static inline int parse_int(const char **pp, const char *end, int *out) {
+
+    const char *p = *pp;
+    while (p < end && is_space(*p)) p++; // Separators: any run of whitespace
+
+    int negative = 0;
+    if (p < end && (*p == '-' || *p == '+')) 
+    {
+        negative = (*p == '-');
+        p++;
+    }
+
+    int run = digit_run(p, end);
+    if (run == 0) 
+    {
+        return 0;
+    }
+
+    // Values are accumulated modulo 2^32, like the multiply kernels
+    unsigned value = 0;
+    for (int d = 0; d < run; d++) 
+    {
+        value = value * 10 + (unsigned)(p[d] - '0');
+    }
+    p += run;
+    while (run == 16 && p < end && (unsigned)(*p - '0') <= 9) // Unusually long numbers
+    {
+        value = value * 10 + (unsigned)(*p++ - '0');
+    }
+
+    *out = (int)(negative ? 0u - value : value);
+    *pp = p;
+    return 1;
+}
+
+// Sequential parse of all elements starting at p; reports the first bad element
+static int parse_body(const char *p, const char *end, Matrix *mat, const char *filename) {
+
+    // Read matrix elements row by row
+    for (int i = 0; i < mat->rows; i++) 
+    {
+        int *row = MAT_ROW(mat, i); // Destination row inside the contiguous buffer
+        for (int j = 0; j < mat->cols; j++) 
+        {
+            // Read single integer element
+            if (!parse_int(&p, end, &row[j])) 
+            {
+                fprintf(stderr, "Error reading matrix element (%d, %d) from %s\n", i, j, filename);
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+//------------------------------
+// Parallel Chunked Parsing
+//------------------------------
+
+// Bodies smaller than this are parsed on the calling thread
+#define PARALLEL_PARSE_MIN_BYTES (4u << 20)
+// Chunks per worker, so uneven chunks still balance across the pool
+#define CHUNKS_PER_WORKER 4
+
+// A slice of the body that starts at the beginning of a line, so no number straddles two chunks
+typedef struct {
+    const char *begin;
+    const char *end;
+    size_t tokens;        // Whitespace-separated tokens in the chunk (pass 1)
+    size_t first_token;   // Tokens in all earlier chunks = linear index of our first element
+    int ok;               // Every token we stored was a complete integer (pass 2)
+} TextChunk;
+
+typedef struct {
+    TextChunk *chunks;
+    Matrix *mat;
+    size_t total;         // rows * cols: tokens beyond this are ignored, like the sequential parser
+} ChunkJob;
+
+// Number of tokens (runs of non-whitespace) in [p, end), where p is at a token boundary
+static size_t count_tokens(const char *p, const char *end) {
+
+    size_t count = 0;
+    int in_token = 0;
+#ifdef __SSE2__
+    // 16 bytes at a time: a token starts where a non-space byte follows a space byte
+    for (; end - p >= 16; p += 16) 
+    {
+        __m128i bytes = _mm_loadu_si128((const __m128i *)p);
+        __m128i blank = _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')),
+                                     _mm_cmpeq_epi8(_mm_min_epu8(_mm_sub_epi8(bytes, _mm_set1_epi8('\t')), _mm_set1_epi8(4)),
+                                                    _mm_sub_epi8(bytes, _mm_set1_epi8('\t')))); // '\t'..'\r'
+        unsigned solid = ~(unsigned)_mm_movemask_epi8(blank) & 0xFFFFu;
+        unsigned starts = solid & ~((solid << 1) | (unsigned)in_token);
+        count += (size_t)__builtin_popcount(starts);
+        in_token = (solid >> 15) & 1;
+    }
+#endif
+    for (; p < end; p++) 
+    {
+        int solid = !is_space(*p);
+        count += (size_t)(solid && !in_token);
+        in_token = solid;
+    }
+    return count;
+}
+
+// Pass 1: count the tokens of chunks [first, last)
+static void count_chunks(void *arg, size_t first, size_t last) {
+
+    ChunkJob *job = (ChunkJob *)arg;
+    for (size_t c = first; c < last; c++) 
+    {
+        job->chunks[c].tokens = count_tokens(job->chunks[c].begin, job->chunks[c].end);
+    }
+}
+
+// Pass 2: parse chunks [first, last) straight into their elements of the matrix
+static void parse_chunks(void *arg, size_t first, size_t last) {
+
+    ChunkJob *job = (ChunkJob *)arg;
+    const size_t cols = (size_t)job->mat->cols;
+
+    for (size_t c = first; c < last; c++) 
+    {
+        TextChunk *chunk = &job->chunks[c];
+        const char *p = chunk->begin;
+        size_t idx = chunk->first_token;
+        size_t stop = chunk->first_token + chunk->tokens;
+        if (stop > job->total) stop = job->total;
+
+        chunk->ok = 1;
+        for (; idx < stop; idx++) 
+        {
+            int *dst = &MAT_ROW(job->mat, idx / cols)[idx % cols];
+            // Each token must be exactly one integer; anything else is left to the sequential parser
+            if (!parse_int(&p, chunk->end, dst) || (p < chunk->end && !is_space(*p))) 
+            {
+                chunk->ok = 0;
+                break;
+            }
+        }
+    }
+}
+
+// Split [p, end) at newlines into chunks, count tokens per chunk in parallel, turn the
+// counts into starting element indices, then parse every chunk in parallel.
+// Returns 0 on success, -1 if the body is malformed or short (caller re-parses sequentially).
+static int parse_body_parallel(const char *p, const char *end, Matrix *mat, ThreadPool *pool) {
+
+    size_t nchunks = pool->num_workers * CHUNKS_PER_WORKER;
+    size_t target = (size_t)(end - p) / nchunks + 1;
+    TextChunk *chunks = calloc(nchunks, sizeof(TextChunk));
+    if (!chunks) 
+    {
+        perror("calloc");
+        exit(EXIT_FAILURE);
+    }
+
+    // Cut roughly equal slices, moving each cut forward to just past a newline
+    size_t used = 0;
+    const char *begin = p;
+    while (begin < end && used < nchunks) 
+    {
+        const char *cut = (size_t)(end - begin) > target ? begin + target : end;
+        if (cut < end) 
+        {
+            const char *newline = memchr(cut, '\n', (size_t)(end - cut));
+            cut = newline ? newline + 1 : end;
+        }
+        if (used == nchunks - 1) cut = end; // Last chunk takes the rest
+        chunks[used].begin = begin;
+        chunks[used].end = cut;
+        used++;
+        begin = cut;
+    }
+
+    ChunkJob job = { chunks, mat, (size_t)mat->rows * mat->cols };
+    TaskGroup group = { 0 }; // Only our chunks: another file may be parsing on the pool too
+
+    pool_submit_range_group(pool, &group, count_chunks, &job, 0, used, 1);
+    pool_group_wait(pool, &group);
+
+    size_t prefix = 0; // Exclusive prefix sum of token counts
+    for (size_t c = 0; c < used; c++) 
+    {
+        chunks[c].first_token = prefix;
+        prefix += chunks[c].tokens;
+    }
+
+    int result = -1;
+    if (prefix >= job.total) 
+    {
+        pool_submit_range_group(pool, &group, parse_chunks, &job, 0, used, 1);
+        pool_group_wait(pool, &group);
+        result = 0;
+        for (size_t c = 0; c < used; c++) 
+        {
+            if (chunks[c].first_token < job.total && !chunks[c].ok) result = -1;
+        }
+    }
+    free(chunks);
+    return result;
+}
+
+//------------------------------
+// Binary Input
+//------------------------------
+
+static int is_binary_matrix(const FileBuffer *fb) {
+
+    return fb->len >= sizeof(MatrixFileHeader) && memcmp(fb->data, MATRIX_BIN_MAGIC, 8) == 0;
+}
+
+// Validate a binary header against the file length; reports and returns -1 if unusable
+static int check_binary_header(const MatrixFileHeader *hdr, uint64_t file_len, MatrixType type, const char *filename) {
+
+    const size_t elem_size = matrix_type_size(type);
+    if (hdr->version != MATRIX_BIN_VERSION || hdr->endian != MATRIX_BIN_ENDIAN) 
+    {
+        fprintf(stderr, "Error: unsupported binary matrix version or byte order in %s\n", filename);
+        return -1;
+    }
+    if (hdr->elem_type != MATRIX_ELEM_INT32 + (uint32_t)type || hdr->elem_size != elem_size) 
+    {
+        fprintf(stderr, "Error: %s does not hold %s elements\n", filename, matrix_type_name(type));
+        return -1;
+    }
+    if (hdr->rows == 0 || hdr->cols == 0 || hdr->rows > INT32_MAX || hdr->cols > INT32_MAX
+        || hdr->stride < hdr->cols || hdr->stride > INT32_MAX
+        || hdr->data_offset < sizeof(*hdr) || hdr->data_offset % elem_size != 0) 
+    {
+        fprintf(stderr, "Error: invalid binary matrix header in %s\n", filename);
+        return -1;
+    }
+    // rows and stride are at most INT32_MAX, so the element count cannot overflow; comparing
+    // it against the elements left after data_offset avoids adding the untrusted offset
+    uint64_t elements = (hdr->rows - 1) * hdr->stride + hdr->cols;
+    if (hdr->data_offset > file_len || elements > (file_len - hdr->data_offset) / elem_size) 
+    {
+        fprintf(stderr, "Error: %s is truncated\n", filename);
+        return -1;
+    }
+    return 0;
+}
+
+// Build a Matrix over a binary file. A mapped file becomes the matrix's backing store
+// as is (the mapping is handed over to the matrix); anything else is copied.
+static Matrix *load_binary_matrix(FileBuffer *fb, MatrixType type, const char *filename) {
+
+    MatrixFileHeader hdr;
+    memcpy(&hdr, fb->data, sizeof(hdr));
+
+    if (check_binary_header(&hdr, fb->len, type, filename) != 0) 
+    {
+        release_file(fb);
+        return NULL;
+    }
+
+    const int rows = (int)hdr.rows, cols = (int)hdr.cols, stride = (int)hdr.stride;
+    const size_t elem_size = matrix_type_size(type);
+    const char *elements = fb->data + hdr.data_offset;
+
+    if (fb->mapped) // Zero copy: the mapping is the element buffer
+    {
+        Matrix *mat = calloc(1, sizeof(Matrix));
+        if (!mat) 
+        {
+            perror("calloc");
+            exit(EXIT_FAILURE);
+        }
+        mat->rows = rows;
+        mat->cols = cols;
+        mat->stride = stride;
+        mat->type = type;
+        mat->data = (int *)(void *)elements;
+        mat->map = fb->data;
+        mat->map_len = fb->len;
+        madvise(fb->data, fb->len, MADV_WILLNEED); // Random access from here on
+        return mat;
+    }
+
+    Matrix *mat = create_matrix_typed(rows, cols, type);
+    for (int i = 0; i < rows; i++) 
+    {
+        memcpy((char *)mat->data + (size_t)i * mat->stride * elem_size,
+               elements + (size_t)i * stride * elem_size, (size_t)cols * elem_size);
+    }
+    release_file(fb);
+    return mat;
+}
+
+//------------------------------
+// Text Input
+//------------------------------
+
+// Parse the "row=x col=y" header line at *pp and step past it; reports and returns -1 if invalid.
+// A sparse file's header carries " nnz=z" as well; *nnz is set to z, or to -1 for dense files.
+static int parse_header(const char **pp, const char *end, int *rows, int *cols, long long *nnz, const char *filename) {
+
+    // The header is the first line (up to 255 characters, as with fgets)
+    const char *p = *pp;
+    char buffer[256];
+    const char *newline = memchr(p, '\n', (size_t)(end - p));
+    size_t header_len = (newline ? (size_t)(newline - p) : (size_t)(end - p));
+    if (header_len > sizeof(buffer) - 1) header_len = sizeof(buffer) - 1;
+    memcpy(buffer, p, header_len);
+    buffer[header_len] = '\0';
+    *pp = p + header_len + (newline && p + header_len == newline ? 1 : 0);
+
+    // Parse dimensions from header line
+    int fields = sscanf(buffer, "row=%d col=%d nnz=%lld", rows, cols, nnz);
+    if (fields == 2) *nnz = -1;
+    if (fields < 2 || (fields == 3 && *nnz < 0))
+    {
+        fprintf(stderr, "Error: invalid header format in %s\n", filename);
+        return -1;
+    }
+
+    // Validate matrix dimensions (any positive size is accepted, there is no upper cap)
+    if (*rows <= 0 || *cols <= 0) 
+    {
+        fprintf(stderr, "Error: invalid matrix dimensions in %s\n", filename);
+        return -1;
+    }
+    return 0;
+}
+
+// Parse the nnz "i j value" lines of a sparse file (0-based indices)
+static int parse_entries(const char *p, const char *end, int rows, int cols, size_t nnz,
+                         MatrixEntry *entries, const char *filename) {
+
+    for (size_t e = 0; e < nnz; e++) 
+    {
+        MatrixEntry *entry = &entries[e];
+        if (!parse_int(&p, end, &entry->row) || !parse_int(&p, end, &entry->col)
+            || !parse_int(&p, end, &entry->value)
+            || entry->row < 0 || entry->row >= rows || entry->col < 0 || entry->col >= cols) 
+        {
+            fprintf(stderr, "Error reading matrix entry %zu from %s\n", e, filename);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Dimensions of a matrix file of any format, from its header alone; 0 on success
+int read_matrix_shape(const char *filename, int *rows, int *cols) {
+
+    char head[256];
+    FILE *fp = fopen(filename, "rb");
+    if (!fp) 
+    {
+        perror(filename);
+        return -1;
+    }
+    size_t len = fread(head, 1, sizeof(head), fp);
+    fclose(fp);
+
+    if (len >= sizeof(MatrixFileHeader) && memcmp(head, MATRIX_BIN_MAGIC, 8) == 0) 
+    {
+        MatrixFileHeader hdr;
+        memcpy(&hdr, head, sizeof(hdr));
+        if (hdr.rows == 0 || hdr.cols == 0 || hdr.rows > INT_MAX || hdr.cols > INT_MAX) 
+        {
+            fprintf(stderr, "Error: invalid matrix dimensions in %s\n", filename);
+            return -1;
+        }
+        *rows = (int)hdr.rows;
+        *cols = (int)hdr.cols;
+        return 0;
+    }
+    const char *p = head;
+    long long nnz;
+    return parse_header(&p, head + len, rows, cols, &nnz, filename);
+}
+
+// Reads the entries of a sparse file. Returns 1 with *entries (malloc'd, *count of
+// them) set, 0 if the file is a dense matrix (nothing is read), -1 on error.
+int read_matrix_entries(const char *filename, int *rows, int *cols, MatrixEntry **entries, size_t *count) {
+
+    FileBuffer fb;
+    if (load_file(filename, &fb) != 0) 
+    {
+        return -1;
+    }
+    const char *p = fb.data;
+    const char *end = fb.data + fb.len;
+    if (fb.len == 0) 
+    {
+        release_file(&fb);
+        return -1; // File empty
+    }
+    if (is_binary_matrix(&fb)) 
+    {
+        release_file(&fb);
+        return 0;
+    }
+    long long nnz;
+    if (parse_header(&p, end, rows, cols, &nnz, filename) != 0) 
+    {
+        release_file(&fb);
+        return -1;
+    }
+    if (nnz < 0) // Dense text
+    {
+        release_file(&fb);
+        return 0;
+    }
+
+    *entries = malloc(((size_t)nnz + 1) * sizeof(MatrixEntry));
+    if (!*entries) 
+    {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    *count = (size_t)nnz;
+    int status = parse_entries(p, end, *rows, *cols, (size_t)nnz, *entries, filename);
+    release_file(&fb);
+    if (status != 0) 
+    {
+        free(*entries);
+        *entries = NULL;
+        return -1;
+    }
+    return 1;
+}
+
+// Next int64 element at *pp (wrapping modulo 2^64, like the int64 kernels); 0 if there is none
+static int parse_int64(const char **pp, const char *end, int64_t *out) {
+
+    const char *p = *pp;
+    while (p < end && is_space(*p)) p++;
+
+    int negative = 0;
+    if (p < end && (*p == '-' || *p == '+')) 
+    {
+        negative = (*p == '-');
+        p++;
+    }
+    if (p == end || (unsigned)(*p - '0') > 9) 
+    {
+        return 0;
+    }
+    uint64_t value = 0;
+    while (p < end && (unsigned)(*p - '0') <= 9) 
+    {
+        value = value * 10 + (uint64_t)(*p++ - '0');
+    }
+    *out = (int64_t)(negative ? 0 - value : value);
+    *pp = p;
+    return 1;
+}
+
+// Next floating-point element at *pp, correctly rounded to float or double; 0 if there is none
+static int parse_real(const char **pp, const char *end, MatrixType type, void *out) {
+
+    const char *p = *pp;
+    while (p < end && is_space(*p)) p++;
+
+    // strtod() needs a terminated token; the input may be a mapping without one
+    char token[64];
+    size_t len = 0;
+    while (p + len < end && !is_space(p[len]) && len < sizeof(token) - 1) 
+    {
+        token[len] = p[len];
+        len++;
+    }
+    token[len] = '\0';
+
+    char *stop;
+    if (type == MATRIX_FLOAT) *(float *)out = strtof(token, &stop);
+    else *(double *)out = strtod(token, &stop);
+    if (len == 0 || stop != token + len) 
+    {
+        return 0;
+    }
+    *pp = p + len;
+    return 1;
+}
+
+// Sequential parser for the element types other than int32
+static int parse_body_typed(const char *p, const char *end, Matrix *mat, const char *filename) {
+
+    for (int i = 0; i < mat->rows; i++) 
+    {
+        for (int j = 0; j < mat->cols; j++) 
+        {
+            int ok;
+            switch (mat->type) 
+            {
+                case MATRIX_INT64: ok = parse_int64(&p, end, &MAT_ROW_AS(int64_t, mat, i)[j]); break;
+                case MATRIX_FLOAT: ok = parse_real(&p, end, MATRIX_FLOAT, &MAT_ROW_AS(float, mat, i)[j]); break;
+                default:           ok = parse_real(&p, end, MATRIX_DOUBLE, &MAT_ROW_AS(double, mat, i)[j]); break;
+            }
+            if (!ok) 
+            {
+                fprintf(stderr, "Error reading matrix element (%d, %d) from %s\n", i, j, filename);
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+// Reads an int32 matrix from a file. Binary files (MATRIX_BIN_MAGIC) are mapped and used
+// in place; text files ("row=x col=y" header line followed by the elements) are parsed,
+// in parallel chunks for large files when a pool is given. pool may be NULL.
+Matrix *read_matrix_from_file(const char *filename, ThreadPool *pool) {
+
+    return read_matrix_as(filename, MATRIX_INT32, pool);
+}
+
+// The same for any element type. Binary files must hold that type; text is parsed as
+// it (sequentially for the types other than int32). Sparse files are int32 only.
+Matrix *read_matrix_as(const char *filename, MatrixType type, ThreadPool *pool) {
+
+    // Map (or read) the whole file in one go
+    FileBuffer fb;
+    if (load_file(filename, &fb) != 0) 
+    {
+        return NULL;
+    }
+    const char *p = fb.data;
+    const char *end = fb.data + fb.len;
+    if (fb.len == 0) 
+    {
+        release_file(&fb);
+        return NULL; // File empty
+    }
+    if (is_binary_matrix(&fb)) 
+    {
+        return load_binary_matrix(&fb, type, filename);
+    }
+
+    int rows, cols;
+    long long nnz;
+    if (parse_header(&p, end, &rows, &cols, &nnz, filename) != 0) 
+    {
+        release_file(&fb);
+        return NULL;
+    }
+    if (nnz >= 0 && type != MATRIX_INT32) 
+    {
+        fprintf(stderr, "Error: sparse matrix %s can only be read as int32\n", filename);
+        release_file(&fb);
+        return NULL;
+    }
+    if (type != MATRIX_INT32) 
+    {
+        Matrix *mat = create_matrix_typed(rows, cols, type);
+        int status = parse_body_typed(p, end, mat, filename);
+        release_file(&fb);
+        if (status != 0) 
+        {
+            free_matrix(mat);
+            return NULL;
+        }
+        return mat;
+    }
+    if (nnz >= 0) // Sparse file: scatter its entries into a zeroed dense matrix
+    {
+        Matrix *mat = create_matrix(rows, cols);
+        MatrixEntry *entries = malloc(((size_t)nnz + 1) * sizeof(MatrixEntry));
+        if (!entries) 
+        {
+            perror("malloc");
+            exit(EXIT_FAILURE);
+        }
+        int status = parse_entries(p, end, rows, cols, (size_t)nnz, entries, filename);
+        for (size_t e = 0; status == 0 && e < (size_t)nnz; e++) 
+        {
+            int *dst = &MAT_ROW(mat, entries[e].row)[entries[e].col];
+            *dst = (int)((unsigned)*dst + (unsigned)entries[e].value); // Repeated entries add up
+        }
+        free(entries);
+        release_file(&fb);
+        if (status != 0) 
+        {
+            free_matrix(mat);
+            return NULL;
+        }
+        return mat;
+    }
+
+    // Allocate matrix structure
+    Matrix *mat = create_matrix(rows, cols);
+
+    // Parse the elements: in parallel chunks for large bodies, falling back to the
+    // sequential parser (which reports the exact bad element) if anything looks wrong
+    int parsed = -1;
+    if (pool && pool->num_workers > 1 && (size_t)(end - p) >= PARALLEL_PARSE_MIN_BYTES) 
+    {
+        parsed = parse_body_parallel(p, end, mat, pool);
+    }
+    if (parsed != 0 && parse_body(p, end, mat, filename) != 0) 
+    {
+        free_matrix(mat);  // Cleanup partially read matrix
+        release_file(&fb);
+        return NULL;
+    }
+
+    release_file(&fb);
+    return mat;  // Return fully initialized matrix
+}
+
+//------------------------------
+// Text Output
+//------------------------------
+
+// Longest formatted element: "-2147483648 "
+#define MAX_ELEMENT_CHARS 12
+// ... for the other types: "-9223372036854775808 ", "%.9g " and "%.17g " of a negative subnormal
+#define MAX_INT64_CHARS  21
+#define MAX_FLOAT_CHARS  17
+#define MAX_DOUBLE_CHARS 26
+// Output formatted per batch before it is written (bounds the writer's memory use)
+#define WRITE_BATCH_BYTES (64u << 20)
+// Row blocks per worker in each batch
+#define BLOCKS_PER_WORKER 4
+
+// "00".."99", so two digits are emitted per division
+static const char digit_pairs[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+// Format value followed by a space (exactly like "%d "); returns the bytes written
+static inline size_t format_element(char *out, int value) {
+
+    char tmp[MAX_ELEMENT_CHARS];
+    char *p = tmp + sizeof(tmp);
+    unsigned v = value < 0 ? 0u - (unsigned)value : (unsigned)value;
+
+    while (v >= 100) 
+    {
+        unsigned pair = (v % 100) * 2;
+        v /= 100;
+        *--p = digit_pairs[pair + 1];
+        *--p = digit_pairs[pair];
+    }
+    if (v >= 10) 
+    {
+        *--p = digit_pairs[v * 2 + 1];
+        *--p = digit_pairs[v * 2];
+    }
+    else 
+    {
+        *--p = (char)('0' + v);
+    }
+    if (value < 0) *--p = '-';
+
+    size_t len = (size_t)(tmp + sizeof(tmp) - p);
+    memcpy(out, p, len);
+    out[len] = ' ';
+    return len + 1;
+}
+
+// format_element() for int64 values
+static inline size_t format_element64(char *out, int64_t value) {
+
+    char tmp[MAX_INT64_CHARS];
+    char *p = tmp + sizeof(tmp);
+    uint64_t v = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+
+    while (v >= 100) 
+    {
+        unsigned pair = (unsigned)(v % 100) * 2;
+        v /= 100;
+        *--p = digit_pairs[pair + 1];
+        *--p = digit_pairs[pair];
+    }
+    if (v >= 10) 
+    {
+        *--p = digit_pairs[v * 2 + 1];
+        *--p = digit_pairs[v * 2];
+    }
+    else 
+    {
+        *--p = (char)('0' + v);
+    }
+    if (value < 0) *--p = '-';
+
+    size_t len = (size_t)(tmp + sizeof(tmp) - p);
+    memcpy(out, p, len);
+    out[len] = ' ';
+    return len + 1;
+}
+
+// Upper bound on the characters of one formatted element, separator included
+static size_t element_chars(MatrixType type) {
+
+    switch (type) 
+    {
+        case MATRIX_INT64:  return MAX_INT64_CHARS;
+        case MATRIX_FLOAT:  return MAX_FLOAT_CHARS;
+        case MATRIX_DOUBLE: return MAX_DOUBLE_CHARS;
+        default:            return MAX_ELEMENT_CHARS;
+    }
+}
+
+// Format rows [first, last) into out; returns the bytes written.
+// Floating-point values get enough digits to read back exactly.
+static size_t format_rows(const Matrix *mat, int first, int last, char *out) {
+
+    char *p = out;
+    for (int i = first; i < last; i++) 
+    {
+        switch (mat->type) 
+        {
+            case MATRIX_INT64:
+                for (int j = 0; j < mat->cols; j++) p += format_element64(p, MAT_ROW_AS(int64_t, mat, i)[j]);
+                break;
+            case MATRIX_FLOAT:
+                for (int j = 0; j < mat->cols; j++) p += sprintf(p, "%.9g ", MAT_ROW_AS(float, mat, i)[j]);
+                break;
+            case MATRIX_DOUBLE:
+                for (int j = 0; j < mat->cols; j++) p += sprintf(p, "%.17g ", MAT_ROW_AS(double, mat, i)[j]);
+                break;
+            default:
+                {
+                    const int *row = MAT_ROW(mat, i);
+                    for (int j = 0; j < mat->cols; j++) 
+                    {
+                        p += format_element(p, row[j]);  // Space-separated values
+                    }
+                }
+                break;
+        }
+        *p++ = '\n';  // Newline after each row
+    }
+    return (size_t)(p - out);
+}
+
+// pwrite() all of buf at offset, retrying short and interrupted writes
+static int write_all(int fd, const char *buf, size_t len, off_t offset) {
+
+    while (len > 0) 
+    {
+        ssize_t put = pwrite(fd, buf, len, offset);
+        if (put < 0 && errno == EINTR) continue;
+        if (put <= 0) 
+        {
+            if (put == 0) errno = EIO; // No progress: would spin forever
+            return -1;
+        }
+        buf += put;
+        len -= (size_t)put;
+        offset += put;
+    }
+    return 0;
+}
+
+// One block of consecutive rows, formatted into its own buffer
+typedef struct {
+    int first_row;
+    int last_row;
+    char *text;
+    size_t len;
+    off_t offset;     // File position, known once all earlier blocks are formatted
+    int failed;
+} RowBlock;
+
+typedef struct {
+    const Matrix *mat;
+    RowBlock *blocks;
+    int fd;
+} WriteJob;
+
+static void format_blocks(void *arg, size_t first, size_t last) {
+
+    WriteJob *job = (WriteJob *)arg;
+    for (size_t b = first; b < last; b++) 
+    {
+        RowBlock *blk = &job->blocks[b];
+        blk->len = format_rows(job->mat, blk->first_row, blk->last_row, blk->text);
+    }
+}
+
+static void write_blocks(void *arg, size_t first, size_t last) {
+
+    WriteJob *job = (WriteJob *)arg;
+    for (size_t b = first; b < last; b++) 
+    {
+        RowBlock *blk = &job->blocks[b];
+        blk->failed = write_all(job->fd, blk->text, blk->len, blk->offset) != 0;
+    }
+}
+
+// Writes a matrix to a text file in the specified format ("row=x col=y" line, then
+// each row as "%d " elements and a newline). Rows are formatted into large buffers a
+// batch at a time; with a pool, the blocks of a batch are formatted and written with
+// pwrite() at their precomputed offsets in parallel. pool may be NULL. Returns 0 on
+// success, -1 (after reporting the error) otherwise.
+int write_matrix_to_file(const char *filename, Matrix *mat, ThreadPool *pool) {
+
+    // open the output file in write mode
+    int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        perror(filename);  // Display system error message
+        return -1;         // Abort operation if file can't be opened
+    }
+
+    // Write matrix dimensions header line
+    char header[64];
+    int header_len = snprintf(header, sizeof(header), "row=%d col=%d\n", mat->rows, mat->cols);
+    if (write_all(fd, header, (size_t)header_len, 0) != 0) 
+    {
+        perror(filename);
+        close(fd);
+        return -1;
+    }
+    off_t offset = header_len;
+
+    // Split each batch of rows into blocks, a few per worker
+    const size_t row_bytes = (size_t)mat->cols * element_chars(mat->type) + 1; // Upper bound per row
+    size_t workers = pool ? pool->num_workers : 1;
+    size_t max_blocks = workers * BLOCKS_PER_WORKER;
+    size_t batch_rows = WRITE_BATCH_BYTES / row_bytes;
+    if (batch_rows < max_blocks) batch_rows = max_blocks;  // At least one row per block
+    size_t block_rows = (batch_rows + max_blocks - 1) / max_blocks;
+
+    RowBlock *blocks = calloc(max_blocks, sizeof(RowBlock));
+    char *text = malloc(max_blocks * block_rows * row_bytes);
+    if (!blocks || !text) 
+    {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    WriteJob job = { mat, blocks, fd };
+    TaskGroup group = { 0 }; // Waits for our blocks only, so other work can share the pool
+
+    int failed = 0;
+    for (int row = 0; row < mat->rows && !failed; ) 
+    {
+        // Lay out this batch's blocks
+        size_t used = 0;
+        for (; used < max_blocks && row < mat->rows; used++) 
+        {
+            blocks[used].first_row = row;
+            blocks[used].last_row = (size_t)(mat->rows - row) > block_rows ? row + (int)block_rows : mat->rows;
+            blocks[used].text = text + used * block_rows * row_bytes;
+            row = blocks[used].last_row;
+        }
+
+        // Format, assign offsets in row order, then write
+        if (pool) 
+        {
+            pool_submit_range_group(pool, &group, format_blocks, &job, 0, used, 1);
+            pool_group_wait(pool, &group);
+        }
+        else 
+        {
+            format_blocks(&job, 0, used);
+        }
+        for (size_t b = 0; b < used; b++) 
+        {
+            blocks[b].offset = offset;
+            offset += (off_t)blocks[b].len;
+        }
+        if (pool) 
+        {
+            pool_submit_range_group(pool, &group, write_blocks, &job, 0, used, 1);
+            pool_group_wait(pool, &group);
+        }
+        else 
+        {
+            write_blocks(&job, 0, used);
+        }
+        for (size_t b = 0; b < used; b++) 
+        {
+            failed |= blocks[b].failed;
+        }
+    }
+
+    if (failed) 
+    {
+        perror(filename);
+    }
+    free(text);
+    free(blocks);
+    close(fd); // Close the file
+    return failed ? -1 : 0;
+}
+
+//------------------------------
+// Binary Output
+//------------------------------
+
+// Header for rows x cols elements laid out stride apart right after the header
+static void fill_binary_header(MatrixFileHeader *hdr, int rows, int cols, int stride, MatrixType type) {
+
+    memset(hdr, 0, sizeof(*hdr));
+    memcpy(hdr->magic, MATRIX_BIN_MAGIC, 8);
+    hdr->version = MATRIX_BIN_VERSION;
+    hdr->endian = MATRIX_BIN_ENDIAN;
+    hdr->elem_type = MATRIX_ELEM_INT32 + (uint32_t)type;
+    hdr->elem_size = (uint32_t)matrix_type_size(type);
+    hdr->align = MATRIX_ALIGN;
+    hdr->rows = (uint64_t)rows;
+    hdr->cols = (uint64_t)cols;
+    hdr->stride = (uint64_t)stride;
+    hdr->data_offset = MATRIX_ALIGN; // The 64-byte header fills exactly one aligned slot
+}
+
+// Writes a matrix in the binary format: header, then every row at its padded stride.
+// Returns 0 on success, -1 on error (already reported).
+int write_matrix_binary(const char *filename, const Matrix *mat) {
+
+    int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) 
+    {
+        perror(filename);
+        return -1;
+    }
+
+    MatrixFileHeader hdr;
+    fill_binary_header(&hdr, mat->rows, mat->cols, mat->stride, mat->type);
+
+    // Rows are contiguous at the matrix's stride, so the body is a single write
+    size_t body = ((size_t)(mat->rows - 1) * mat->stride + mat->cols) * matrix_type_size(mat->type);
+    if (write_all(fd, (const char *)&hdr, sizeof(hdr), 0) != 0
+        || write_all(fd, (const char *)mat->data, body, (off_t)hdr.data_offset) != 0) 
+    {
+        perror(filename);
+        close(fd);
+        return -1;
+    }
+    close(fd);
+    return 0;
+}
+
+//------------------------------
+// File Copies
+//------------------------------
+
+// Plain read()/write() copy of the rest of in_fd, when the kernel cannot copy for us
+static int copy_by_hand(int in_fd, int out_fd) {
+
+    char *buf = malloc(1 << 20);
+    if (!buf) 
+    {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    ssize_t got;
+    off_t offset = lseek(out_fd, 0, SEEK_CUR);
+    while ((got = read(in_fd, buf, 1 << 20)) > 0) 
+    {
+        if (write_all(out_fd, buf, (size_t)got, offset) != 0) 
+        {
+            got = -1;
+            break;
+        }
+        offset += got;
+    }
+    free(buf);
+    return got < 0 ? -1 : 0;
+}
+
+int copy_matrix_file(const char *src, const char *dst) {
+
+    int in_fd = open(src, O_RDONLY);
+    if (in_fd < 0) 
+    {
+        perror(src);
+        return -1;
+    }
+    int out_fd = open(dst, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (out_fd < 0) 
+    {
+        perror(dst);
+        close(in_fd);
+        return -1;
+    }
+
+    // Reflink: both names share the same extents until one of them is rewritten
+    int status = 0;
+    if (ioctl(out_fd, FICLONE, in_fd) != 0) 
+    {
+        struct stat st;
+        if (fstat(in_fd, &st) != 0) 
+        {
+            status = -1;
+        }
+        size_t left = status == 0 ? (size_t)st.st_size : 0;
+        while (left > 0) 
+        {
+            ssize_t put = copy_file_range(in_fd, NULL, out_fd, NULL, left, 0);
+            if (put <= 0) // Not supported here (old kernel, other filesystem): finish by hand
+            {
+                status = put < 0 && errno != ENOSYS && errno != EXDEV && errno != EINVAL && errno != EOPNOTSUPP
+                         ? -1 : copy_by_hand(in_fd, out_fd);
+                break;
+            }
+            left -= (size_t)put;
+        }
+    }
+    if (status != 0) 
+    {
+        perror(dst);
+    }
+    close(in_fd);
+    if (close(out_fd) != 0 && status == 0) 
+    {
+        perror(dst);
+        status = -1;
+    }
+    return status;
+}
+
+//------------------------------
+// Streaming Access
+//------------------------------
+// Panels of rows (or, for binary files, any block) of a matrix that is never held
+// in memory whole. Text files are tokenized through a fixed window and can only be
+// read front to back; binary files are read with pread() at any position.
+
+#define READER_WINDOW_BYTES (1u << 20)
+#define READER_LOOKAHEAD    4096   // Bytes kept ahead of the cursor so no token is cut at the window edge
+#define WRITER_BUFFER_BYTES (8u << 20)
+
+struct MatrixReader {
+    int fd;
+    char *filename;
+    int rows;
+    int cols;
+    int binary;
+    // Binary files
+    uint64_t stride;
+    uint64_t data_offset;
+    // Text files
+    char *window;
+    size_t pos;        // Cursor in window
+    size_t len;        // Valid bytes in window
+    int eof;           // Nothing left to read after window[len]
+    int next_row;      // Rows are consumed in order
+};
+
+struct MatrixWriter {
+    int fd;
+    char *filename;
+    int rows;
+    int cols;
+    int binary;
+    int stride;        // Row pitch of binary files (as create_matrix)
+    int next_row;
+    off_t offset;      // End of the text written so far
+    char *text;        // Formatting buffer for text files
+    size_t text_size;
+};
+
+// Move the unread tail of the window to the front and top it up
+static int refill_window(MatrixReader *r) {
+
+    memmove(r->window, r->window + r->pos, r->len - r->pos);
+    r->len -= r->pos;
+    r->pos = 0;
+    while (!r->eof && r->len < READER_WINDOW_BYTES) 
+    {
+        ssize_t got = read(r->fd, r->window + r->len, READER_WINDOW_BYTES - r->len);
+        if (got < 0) 
+        {
+            if (errno == EINTR) continue;
+            perror(r->filename);
+            return -1;
+        }
+        if (got == 0) r->eof = 1;
+        r->len += (size_t)got;
+    }
+    return 0;
+}
+
+// pread() exactly len bytes at offset
+static int read_all(int fd, char *buf, size_t len, off_t offset) {
+
+    while (len > 0) 
+    {
+        ssize_t got = pread(fd, buf, len, offset);
+        if (got <= 0) 
+        {
+            if (got < 0 && errno == EINTR) continue;
+            return -1;
+        }
+        buf += got;
+        len -= (size_t)got;
+        offset += got;
+    }
+    return 0;
+}
+
+// Open a text or binary matrix file for panel reads; NULL on error (already reported)
+MatrixReader *open_matrix_reader(const char *filename) {
+
+    MatrixReader *r = calloc(1, sizeof(MatrixReader));
+    if (r) 
+    {
+        r->filename = strdup(filename);
+        r->window = malloc(READER_WINDOW_BYTES);
+    }
+    if (!r || !r->filename || !r->window) 
+    {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+
+    r->fd = open(filename, O_RDONLY);
+    if (r->fd < 0) 
+    {
+        perror(filename);
+        close_matrix_reader(r);
+        return NULL;
+    }
+    if (refill_window(r) != 0 || r->len == 0) 
+    {
+        close_matrix_reader(r);
+        return NULL; // Unreadable or empty
+    }
+
+    if (r->len >= sizeof(MatrixFileHeader) && memcmp(r->window, MATRIX_BIN_MAGIC, 8) == 0) 
+    {
+        MatrixFileHeader hdr;
+        memcpy(&hdr, r->window, sizeof(hdr));
+        struct stat st;
+        if (fstat(r->fd, &st) != 0 || !S_ISREG(st.st_mode)) 
+        {
+            fprintf(stderr, "Error: %s must be a regular file to be read in panels\n", filename);
+            close_matrix_reader(r);
+            return NULL;
+        }
+        if (check_binary_header(&hdr, (uint64_t)st.st_size, MATRIX_INT32, filename) != 0) 
+        {
+            close_matrix_reader(r);
+            return NULL;
+        }
+        r->binary = 1;
+        r->rows = (int)hdr.rows;
+        r->cols = (int)hdr.cols;
+        r->stride = hdr.stride;
+        r->data_offset = hdr.data_offset;
+        free(r->window);  // Binary panels are read straight into their destination
+        r->window = NULL;
+        return r;
+    }
+
+    const char *p = r->window;
+    long long nnz;
+    if (parse_header(&p, r->window + r->len, &r->rows, &r->cols, &nnz, filename) != 0) 
+    {
+        close_matrix_reader(r);
+        return NULL;
+    }
+    if (nnz >= 0) 
+    {
+        fprintf(stderr, "Error: sparse matrix %s cannot be read in panels\n", filename);
+        close_matrix_reader(r);
+        return NULL;
+    }
+    r->pos = (size_t)(p - r->window);
+    return r;
+}
+
+int matrix_reader_rows(const MatrixReader *r) { return r->rows; }
+int matrix_reader_cols(const MatrixReader *r) { return r->cols; }
+int matrix_reader_is_binary(const MatrixReader *r) { return r->binary; }
+
+// Next text element; reports and returns -1 if it is missing or malformed
+static int next_text_element(MatrixReader *r, int *out, int i, int j) {
+
+    for (;;) // Skip separators, refilling as needed
+    {
+        while (r->pos < r->len && is_space(r->window[r->pos])) r->pos++;
+        if (r->pos < r->len || r->eof) break;
+        if (refill_window(r) != 0) return -1;
+    }
+    if (!r->eof && r->len - r->pos < READER_LOOKAHEAD && refill_window(r) != 0) 
+    {
+        return -1;
+    }
+
+    const char *p = r->window + r->pos;
+    const char *end = r->window + r->len;
+    if (!parse_int(&p, end, out) || (p < end && !is_space(*p))) 
+    {
+        fprintf(stderr, "Error reading matrix element (%d, %d) from %s\n", i, j, r->filename);
+        return -1;
+    }
+    r->pos = (size_t)(p - r->window);
+    return 0;
+}
+
+// Read rows [row0, row0 + nrows) x columns [col0, col0 + ncols) into dst, whose rows
+// are dst_stride elements apart. Text files only support whole rows, in order.
+// Returns 0 on success, -1 on error (already reported).
+int read_matrix_block(MatrixReader *r, int row0, int nrows, int col0, int ncols, int *dst, int dst_stride) {
+
+    if (r->binary) 
+    {
+        const size_t row_bytes = (size_t)ncols * sizeof(int);
+        off_t at = (off_t)(r->data_offset + ((uint64_t)row0 * r->stride + (uint64_t)col0) * sizeof(int));
+        if (col0 == 0 && ncols == r->cols && (uint64_t)dst_stride == r->stride) // One contiguous run
+        {
+            size_t bytes = ((size_t)(nrows - 1) * (size_t)dst_stride + (size_t)ncols) * sizeof(int);
+            if (read_all(r->fd, (char *)dst, bytes, at) != 0) 
+            {
+                perror(r->filename);
+                return -1;
+            }
+            return 0;
+        }
+        for (int i = 0; i < nrows; i++, at += (off_t)(r->stride * sizeof(int))) 
+        {
+            if (read_all(r->fd, (char *)(dst + (size_t)i * dst_stride), row_bytes, at) != 0) 
+            {
+                perror(r->filename);
+                return -1;
+            }
+        }
+        return 0;
+    }
+
+    if (row0 != r->next_row || col0 != 0 || ncols != r->cols) 
+    {
+        fprintf(stderr, "Error: text matrix %s can only be read in whole rows, in order\n", r->filename);
+        return -1;
+    }
+    for (int i = 0; i < nrows; i++) 
+    {
+        int *row = dst + (size_t)i * dst_stride;
+        for (int j = 0; j < ncols; j++) 
+        {
+            if (next_text_element(r, &row[j], row0 + i, j) != 0) return -1;
+        }
+    }
+    r->next_row += nrows;
+    return 0;
+}
+
+void close_matrix_reader(MatrixReader *r) {
+
+    if (!r) return;
+    if (r->fd >= 0) close(r->fd);
+    free(r->window);
+    free(r->filename);
+    free(r);
+}
+
+// Create a rows x cols matrix file to be written in row panels, in text or binary
+// format; NULL on error (already reported)
+MatrixWriter *open_matrix_writer(const char *filename, int rows, int cols, int binary) {
+
+    MatrixWriter *w = calloc(1, sizeof(MatrixWriter));
+    if (w) w->filename = strdup(filename);
+    if (!w || !w->filename) 
+    {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    w->rows = rows;
+    w->cols = cols;
+    w->binary = binary;
+    w->stride = padded_stride(cols, sizeof(int));
+
+    w->fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (w->fd < 0) 
+    {
+        perror(filename);
+        free(w->filename);
+        free(w);
+        return NULL;
+    }
+
+    int failed;
+    if (binary) 
+    {
+        MatrixFileHeader hdr;
+        fill_binary_header(&hdr, rows, cols, w->stride, MATRIX_INT32);
+        failed = write_all(w->fd, (const char *)&hdr, sizeof(hdr), 0) != 0;
+    }
+    else 
+    {
+        const size_t row_bytes = (size_t)cols * MAX_ELEMENT_CHARS + 1;
+        w->text_size = row_bytes > WRITER_BUFFER_BYTES ? row_bytes : WRITER_BUFFER_BYTES;
+        w->text = malloc(w->text_size);
+        if (!w->text) 
+        {
+            perror("malloc");
+            exit(EXIT_FAILURE);
+        }
+        char header[64];
+        int header_len = snprintf(header, sizeof(header), "row=%d col=%d\n", rows, cols);
+        failed = write_all(w->fd, header, (size_t)header_len, 0) != 0;
+        w->offset = header_len;
+    }
+    if (failed) 
+    {
+        perror(filename);
+        close_matrix_writer(w);
+        return NULL;
+    }
+    return w;
+}
+
+// Append the next count rows, taken from src with rows src_stride elements apart.
+// Returns 0 on success, -1 on error (already reported).
+int write_matrix_rows(MatrixWriter *w, const int *src, int src_stride, int count) {
+
+    if (count > w->rows - w->next_row) 
+    {
+        fprintf(stderr, "Error: too many rows written to %s\n", w->filename);
+        return -1;
+    }
+
+    int failed = 0;
+    if (w->binary) 
+    {
+        off_t at = (off_t)(MATRIX_ALIGN + (size_t)w->next_row * w->stride * sizeof(int));
+        if (src_stride == w->stride) // Same layout: one write
+        {
+            size_t bytes = ((size_t)(count - 1) * w->stride + (size_t)w->cols) * sizeof(int);
+            failed = write_all(w->fd, (const char *)src, bytes, at) != 0;
+        }
+        for (int i = 0; i < count && src_stride != w->stride && !failed; i++) 
+        {
+            failed = write_all(w->fd, (const char *)(src + (size_t)i * src_stride), (size_t)w->cols * sizeof(int),
+                               at + (off_t)((size_t)i * w->stride * sizeof(int))) != 0;
+        }
+    }
+    else 
+    {
+        // Format as many rows as fit in the buffer, write them, repeat
+        const Matrix view = { count, w->cols, src_stride, (int *)src, NULL, 0 };
+        const int rows_per_fill = (int)(w->text_size / ((size_t)w->cols * MAX_ELEMENT_CHARS + 1));
+        for (int i = 0; i < count && !failed; i += rows_per_fill) 
+        {
+            int last = count - i > rows_per_fill ? i + rows_per_fill : count;
+            size_t len = format_rows(&view, i, last, w->text);
+            failed = write_all(w->fd, w->text, len, w->offset) != 0;
+            w->offset += (off_t)len;
+        }
+    }
+    if (failed) 
+    {
+        perror(w->filename);
+        return -1;
+    }
+    w->next_row += count;
+    return 0;
+}
+
+// Close the file; returns -1 if not every row was written
+int close_matrix_writer(MatrixWriter *w) {
+
+    if (!w) return 0;
+    int status = (w->next_row == w->rows) ? 0 : -1;
+    if (w->fd >= 0 && close(w->fd) != 0) 
+    {
+        perror(w->filename);
+        status = -1;
+    }
+    free(w->text);
+    free(w->filename);
+    free(w);
+    return status;
+}
+
+// Writes entries as a sparse text file: "row=x col=y nnz=z" line, then "i j value" lines.
+// Returns 0 on success, -1 on error (already reported).
+int write_matrix_entries(const char *filename, int rows, int cols, const MatrixEntry *entries, size_t count) {
+
+    int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) 
+    {
+        perror(filename);
+        return -1;
+    }
+
+    char *text = malloc(WRITER_BUFFER_BYTES + 3 * MAX_ELEMENT_CHARS);
+    if (!text) 
+    {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    size_t len = (size_t)snprintf(text, 64, "row=%d col=%d nnz=%zu\n", rows, cols, count);
+    off_t offset = 0;
+    int failed = 0;
+    for (size_t e = 0; e <= count && !failed; e++) 
+    {
+        if (len >= WRITER_BUFFER_BYTES || e == count) // Flush a full buffer, and at the end
+        {
+            failed = write_all(fd, text, len, offset) != 0;
+            offset += (off_t)len;
+            len = 0;
+        }
+        if (e == count) break;
+        len += format_element(text + len, entries[e].row);
+        len += format_element(text + len, entries[e].col);
+        len += format_element(text + len, entries[e].value);
+        text[len - 1] = '\n'; // One entry per line
+    }
+    if (failed) 
+    {
+        perror(filename);
+    }
+    free(text);
+    close(fd);
+    return failed ? -1 : 0;
+}
+
+//------------------------------
+// Matrix Streams
+//------------------------------
+// Dense text matrices back to back on one stream (a pipe, say), each with its own
+// "row=x col=y" header. A matrix is read line by line until all of its elements
+// have arrived, so the one behind it is left on the stream for the next call.
+
+int read_matrix_stream(FILE *fp, MatrixType type, const char *name, Matrix **out) {
+
+    char *line = NULL;
+    size_t line_cap = 0;
+    ssize_t got;
+
+    // Header: the next non-blank line
+    do 
+    {
+        got = getline(&line, &line_cap, fp);
+    } while (got > 0 && count_tokens(line, line + got) == 0);
+    if (got <= 0) 
+    {
+        free(line);
+        return 0; // End of the stream
+    }
+    const char *p = line;
+    int rows, cols;
+    long long nnz;
+    if (parse_header(&p, line + got, &rows, &cols, &nnz, name) != 0) 
+    {
+        free(line);
+        return -1;
+    }
+    if (nnz >= 0) 
+    {
+        fprintf(stderr, "Error: sparse matrices cannot be streamed (%s)\n", name);
+        free(line);
+        return -1;
+    }
+
+    // Body: whole lines until rows * cols tokens are in
+    const size_t total = (size_t)rows * cols;
+    size_t tokens = 0, len = 0, cap = 1 << 16;
+    char *body = malloc(cap);
+    if (!body) 
+    {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    while (tokens < total && (got = getline(&line, &line_cap, fp)) > 0) 
+    {
+        if (len + (size_t)got + 1 > cap) 
+        {
+            while (len + (size_t)got + 1 > cap) cap *= 2;
+            char *bigger = realloc(body, cap);
+            if (!bigger) 
+            {
+                perror("realloc");
+                exit(EXIT_FAILURE);
+            }
+            body = bigger;
+        }
+        memcpy(body + len, line, (size_t)got);
+        len += (size_t)got;
+        tokens += count_tokens(line, line + got);
+    }
+    free(line);
+
+    Matrix *mat = create_matrix_typed(rows, cols, type);
+    int status = type == MATRIX_INT32 ? parse_body(body, body + len, mat, name)
+                                      : parse_body_typed(body, body + len, mat, name);
+    free(body);
+    if (status != 0) 
+    {
+        free_matrix(mat);
+        return -1;
+    }
+    *out = mat;
+    return 1;
+}
+
+int write_matrix_stream(FILE *fp, const Matrix *mat) {
+
+    if (fprintf(fp, "row=%d col=%d\n", mat->rows, mat->cols) < 0) 
+    {
+        return -1;
+    }
+    const size_t row_bytes = (size_t)mat->cols * element_chars(mat->type) + 1;
+    size_t batch_rows = WRITE_BATCH_BYTES / row_bytes;
+    if (batch_rows == 0) batch_rows = 1;
+    char *text = malloc(batch_rows * row_bytes);
+    if (!text) 
+    {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    int failed = 0;
+    for (int row = 0; row < mat->rows && !failed; row += (int)batch_rows) 
+    {
+        const int last = (size_t)(mat->rows - row) > batch_rows ? row + (int)batch_rows : mat->rows;
+        const size_t len = format_rows(mat, row, last, text);
+        failed = fwrite(text, 1, len, fp) != len;
+    }
+    free(text);
+    return failed || fflush(fp) != 0 ? -1 : 0;
+}
@@ -0,0 +1,121 @@
+#ifndef MATRIX_H
+#define MATRIX_H
+
+#include <stddef.h>  // size_t
+#include <stdio.h>   // FILE for matrix streams
+#include <stdint.h>  // Fixed-width fields of the binary header
+#include "pool.h"    // Parallel parsing runs on the worker pool
+
+// Byte alignment of the matrix buffer and of every row inside it (one cache line)
+#define MATRIX_ALIGN 64
+
+// Element types. int32 is the default and what every mode supports; the dense
+// methods also handle the others, accumulating int64 modulo 2^64 and float in double.
+typedef enum {
+    MATRIX_INT32,
+    MATRIX_INT64,
+    MATRIX_FLOAT,
+    MATRIX_DOUBLE,
+} MatrixType;
+
+//------------------------------
+// Matrix Structure and Functions
+//------------------------------
+typedef struct {
+    int rows;          // Number of rows
+    int cols;          // Number of columns
+    int stride;        // Distance (in elements) between the starts of two consecutive rows
+    int *data;         // Contiguous row-major buffer: element (i, j) is data[i * stride + j]
+                       // (of the element type: read other types through MAT_ROW_AS)
+    void *map;         // Mapping of a binary file that data points into (NULL: data follows the header)
+    size_t map_len;    // Length of that mapping
+    MatrixType type;   // Element type (zero, MATRIX_INT32, unless created otherwise)
+} Matrix;
+
+// Pointer to the first element of row i
+#define MAT_ROW(mat, i) ((mat)->data + (size_t)(i) * (mat)->stride)
+// The same for a matrix of element type T (int64_t, float or double)
+#define MAT_ROW_AS(T, mat, i) ((T *)(void *)(mat)->data + (size_t)(i) * (mat)->stride)
+
+//------------------------------
+// Binary Matrix Files
+//------------------------------
+// A fixed 64-byte header followed by the raw row-major elements. Rows are `stride`
+// elements apart and start at `data_offset`, both aligned to `align` bytes, so a
+// mapped file can serve directly as a Matrix buffer without copying.
+#define MATRIX_BIN_MAGIC   "MATBIN\r\n"  // \r\n catches files mangled by text-mode transfers
+#define MATRIX_BIN_VERSION 1
+#define MATRIX_BIN_ENDIAN  0x01020304u   // Reads back differently on a machine of the other byte order
+
+enum { MATRIX_ELEM_INT32 = 1, MATRIX_ELEM_INT64, MATRIX_ELEM_FLOAT, MATRIX_ELEM_DOUBLE };  // MatrixType + 1
+
+typedef struct {
+    char magic[8];          // MATRIX_BIN_MAGIC (no terminator)
+    uint32_t version;       // MATRIX_BIN_VERSION
+    uint32_t endian;        // MATRIX_BIN_ENDIAN in the writer's byte order
+    uint32_t elem_type;     // MATRIX_ELEM_*
+    uint32_t elem_size;     // Bytes per element
+    uint32_t align;         // Alignment (bytes) of data_offset and of the row pitch
+    uint32_t reserved;      // Zero
+    uint64_t rows;
+    uint64_t cols;
+    uint64_t stride;        // Elements between the starts of consecutive rows (>= cols)
+    uint64_t data_offset;   // File offset of element (0, 0)
+} MatrixFileHeader;
+
+_Static_assert(sizeof(MatrixFileHeader) == 64, "binary matrix header must be 64 bytes");
+
+// Function prototypes
+Matrix *create_matrix(int rows, int cols);
+Matrix *create_matrix_typed(int rows, int cols, MatrixType type);
+Matrix *allocate_matrix(int rows, int cols, MatrixType type);  // Elements left unwritten (for first touch)
+size_t matrix_bytes(int rows, int cols, MatrixType type);     // Element buffer allocate_matrix() sets aside
+void reshape_matrix(Matrix *mat, int rows, int cols);  // Reuse an allocated buffer of >= matrix_bytes() for a new shape
+void free_matrix(Matrix *mat);
+size_t matrix_type_size(MatrixType type);
+const char *matrix_type_name(MatrixType type);
+int parse_matrix_type(const char *name, MatrixType *type);  // "int32", "int64", "float", "double"; 0 on success
+Matrix *read_matrix_from_file(const char *filename, ThreadPool *pool);  // Text or binary; pool may be NULL
+Matrix *read_matrix_as(const char *filename, MatrixType type, ThreadPool *pool);  // Same, any element type
+int read_matrix_shape(const char *filename, int *rows, int *cols);  // Header only; 0 on success
+int write_matrix_to_file(const char *filename, Matrix *mat, ThreadPool *pool);  // pool may be NULL; 0 on success, -1 on error
+int write_matrix_binary(const char *filename, const Matrix *mat);
+// dst becomes a copy of the file src: a reflink sharing its extents where the
+// filesystem supports it, otherwise copy_file_range(). 0 on success, -1 on error.
+int copy_matrix_file(const char *src, const char *dst);
+
+// Sparse text files: "row=x col=y nnz=z" header, then z "i j value" lines with
+// 0-based indices (repeated positions add up). read_matrix_from_file() returns
+// them as dense matrices; sparse.c builds CSR matrices from their entries.
+typedef struct {
+    int row;
+    int col;
+    int value;
+} MatrixEntry;
+
+int read_matrix_entries(const char *filename, int *rows, int *cols, MatrixEntry **entries, size_t *count);
+int write_matrix_entries(const char *filename, int rows, int cols, const MatrixEntry *entries, size_t count);
+
+// Dense text matrices concatenated on a stream (e.g. stdin/stdout of a pipeline).
+// read_matrix_stream() returns 1 with *out set, 0 at the end of the stream, or -1 on
+// error (already reported; name labels the stream in messages).
+int read_matrix_stream(FILE *fp, MatrixType type, const char *name, Matrix **out);
+int write_matrix_stream(FILE *fp, const Matrix *mat);  // Text; 0 on success, -1 on error
+
+// Panel access to matrix files that are not loaded whole (see stream.c).
+// Text files are read in whole rows, front to back; binary files in any block.
+typedef struct MatrixReader MatrixReader;
+typedef struct MatrixWriter MatrixWriter;
+
+MatrixReader *open_matrix_reader(const char *filename);
+int matrix_reader_rows(const MatrixReader *r);
+int matrix_reader_cols(const MatrixReader *r);
+int matrix_reader_is_binary(const MatrixReader *r);
+int read_matrix_block(MatrixReader *r, int row0, int nrows, int col0, int ncols, int *dst, int dst_stride);
+void close_matrix_reader(MatrixReader *r);
+
+MatrixWriter *open_matrix_writer(const char *filename, int rows, int cols, int binary);
+int write_matrix_rows(MatrixWriter *w, const int *src, int src_stride, int count);  // Appends rows
+int close_matrix_writer(MatrixWriter *w);
+
+#endif
@@ -0,0 +1,355 @@
+#include <stdio.h>   // Standard I/O functions
+#include <stdlib.h>  // Memory management
+#include <stdint.h>  // int64_t
+#include "multiply.h"
+#include "kernels.h"
+#include "placement.h"
+
+//------------------------------
+// Dot Product Helpers
+//------------------------------
+
+// The operands as seen from the calling worker: B and Bt replaced by the copies
+// on its NUMA node when there are per-node copies
+static MatMultArgs local_args(const MatMultArgs *args) {
+
+    MatMultArgs local = *args;
+    if (args->B_nodes) local.B = args->B_nodes[current_node()];
+    if (args->Bt_nodes) local.Bt = args->Bt_nodes[current_node()];
+    return local;
+}
+
+// C[i][j] = A row i . B column j
+static void compute_element(const Kernels *kern, const MatMultArgs *args, int i, int j) {
+
+    const Matrix *A = args->A;
+    const Matrix *B = args->B;
+
+    if (args->Bt) // Column j of B is row j of Bt: two unit-stride streams
+    {
+        MAT_ROW(args->C, i)[j] = kern->dot(MAT_ROW(A, i), MAT_ROW(args->Bt, j), 1, A->cols);
+    }
+    else // Walks down column j of B, one stride per k
+    {
+        MAT_ROW(args->C, i)[j] = kern->dot(MAT_ROW(A, i), B->data + j, (size_t)B->stride, A->cols);
+    }
+}
+
+// All columns of row i of C
+static void compute_row(const Kernels *kern, const MatMultArgs *args, int i) {
+
+    const Matrix *A = args->A;
+    const Matrix *B = args->B;
+
+    if (args->Bt) 
+    {
+        kern->row_packed(MAT_ROW(A, i), args->Bt->data, (size_t)args->Bt->stride, MAT_ROW(args->C, i), B->cols, A->cols);
+    }
+    else 
+    {
+        kern->row(MAT_ROW(A, i), B->data, (size_t)B->stride, MAT_ROW(args->C, i), B->cols, A->cols);
+    }
+}
+
+//------------------------------
+// Wider Element Types
+//------------------------------
+
+// Rows, elements and tiles for one element type T with accumulator ACC, using the
+// matching member of Kernels. B is walked in place (no packed transpose), and tiles
+// sum into an ACC buffer so float results are rounded once, like the other methods.
+#define DEFINE_TYPED_METHODS(T, ACC, field)                                                   \
+    static void rows_##field(const MatMultArgs *args, size_t first, size_t last) {            \
+        const Kernels *kern = get_kernels();                                                  \
+        const Matrix *A = args->A, *B = args->B;                                              \
+        for (size_t i = first; i < last; i++)                                                 \
+        {                                                                                     \
+            kern->field.row(MAT_ROW_AS(T, A, i), (const T *)B->data, (size_t)B->stride,       \
+                            MAT_ROW_AS(T, args->C, i), B->cols, A->cols);                     \
+        }                                                                                     \
+    }                                                                                         \
+    static void elements_##field(const MatMultArgs *args, size_t first, size_t last) {        \
+        const Kernels *kern = get_kernels();                                                  \
+        const Matrix *A = args->A, *B = args->B;                                              \
+        const size_t cols = (size_t)args->C->cols;                                            \
+        for (size_t idx = first; idx < last; idx++)                                           \
+        {                                                                                     \
+            const size_t i = idx / cols, j = idx % cols;                                      \
+            MAT_ROW_AS(T, args->C, i)[j] = kern->field.dot(MAT_ROW_AS(T, A, i),               \
+                (const T *)B->data + j, (size_t)B->stride, A->cols);                          \
+        }                                                                                     \
+    }                                                                                         \
+    static void tiles_##field(const TileMultArgs *args, size_t first, size_t last) {          \
+        const Kernels *kern = get_kernels();                                                  \
+        const Matrix *A = args->A, *B = args->B;                                              \
+        Matrix *C = args->C;                                                                  \
+        const int t2 = args->tile_l2, t1 = args->tile_l1;                                     \
+        const size_t tiles_across = ((size_t)C->cols + t2 - 1) / t2;                          \
+        ACC *scratch = pool_scratch((size_t)t2 * t2 * sizeof(ACC)); /* Worker's, reused */    \
+        ACC *acc = scratch ? scratch : malloc((size_t)t2 * t2 * sizeof(ACC));                 \
+        if (!acc)                                                                             \
+        {                                                                                     \
+            perror("malloc");                                                                 \
+            exit(EXIT_FAILURE);                                                               \
+        }                                                                                     \
+        for (size_t t = first; t < last; t++)                                                 \
+        {                                                                                     \
+            const int i0 = (int)(t / tiles_across) * t2;                                      \
+            const int j0 = (int)(t % tiles_across) * t2;                                      \
+            const int i_end = i0 + t2 < C->rows ? i0 + t2 : C->rows;                          \
+            const int j_end = j0 + t2 < C->cols ? j0 + t2 : C->cols;                          \
+            const int width = j_end - j0;                                                     \
+            for (size_t e = 0; e < (size_t)(i_end - i0) * width; e++) acc[e] = 0;             \
+            for (int k0 = 0; k0 < A->cols; k0 += t2)                                          \
+            {                                                                                 \
+                const int k_end = k0 + t2 < A->cols ? k0 + t2 : A->cols;                      \
+                for (int i1 = i0; i1 < i_end; i1 += t1)                                       \
+                {                                                                             \
+                    const int i1_end = i1 + t1 < i_end ? i1 + t1 : i_end;                     \
+                    for (int k1 = k0; k1 < k_end; k1 += t1)                                   \
+                    {                                                                         \
+                        const int k1_end = k1 + t1 < k_end ? k1 + t1 : k_end;                 \
+                        for (int i = i1; i < i1_end; i++)                                     \
+                        {                                                                     \
+                            const T *a = MAT_ROW_AS(T, A, i);                                 \
+                            ACC *c = acc + (size_t)(i - i0) * width;                          \
+                            for (int k = k1; k < k1_end; k++)                                 \
+                            {                                                                 \
+                                kern->field.axpy(c, a[k], MAT_ROW_AS(T, B, k) + j0, width);   \
+                            }                                                                 \
+                        }                                                                     \
+                    }                                                                         \
+                }                                                                             \
+            }                                                                                 \
+            for (int i = i0; i < i_end; i++)                                                  \
+            {                                                                                 \
+                T *c = MAT_ROW_AS(T, C, i);                                                   \
+                const ACC *src = acc + (size_t)(i - i0) * width;                              \
+                for (int j = 0; j < width; j++) c[j0 + j] = (T)src[j];                        \
+            }                                                                                 \
+        }                                                                                     \
+        if (!scratch) free(acc);                                                              \
+    }
+
+DEFINE_TYPED_METHODS(int64_t, uint64_t, i64)
+DEFINE_TYPED_METHODS(float, double, f32)
+DEFINE_TYPED_METHODS(double, double, f64)
+
+// Rows [first, last) of C for a non-int32 element type
+static void typed_rows(const MatMultArgs *args, size_t first, size_t last) {
+
+    switch (args->C->type) 
+    {
+        case MATRIX_INT64:  rows_i64(args, first, last); break;
+        case MATRIX_FLOAT:  rows_f32(args, first, last); break;
+        case MATRIX_DOUBLE: rows_f64(args, first, last); break;
+        default: break;
+    }
+}
+
+//------------------------------
+// Task Functions
+//------------------------------
+
+// Method 1: One task computes the entire matrix multiplication.
+void multiply_matrix(void *arg) {
+
+    MatMultArgs local = local_args((MatMultArgs *)arg);
+    MatMultArgs *args = &local;
+    const Kernels *kern = get_kernels();
+
+    if (args->C->type != MATRIX_INT32) 
+    {
+        typed_rows(args, 0, (size_t)args->A->rows);
+        return;
+    }
+    for (int i = 0; i < args->A->rows; i++) // Iterate over all rows of matrix A
+    {
+        compute_row(kern, args, i);
+    }
+}
+
+// Method 2: whole rows [first, last) of C.
+void multiply_rows(void *arg, size_t first, size_t last) {
+
+    MatMultArgs local = local_args((MatMultArgs *)arg);
+    MatMultArgs *args = &local;
+    const Kernels *kern = get_kernels();
+
+    if (args->C->type != MATRIX_INT32) 
+    {
+        typed_rows(args, first, last);
+        return;
+    }
+    for (size_t i = first; i < last; i++) 
+    {
+        compute_row(kern, args, (int)i);
+    }
+}
+
+// Method 3: individual elements [first, last) of C in row-major order.
+void multiply_elements(void *arg, size_t first, size_t last) {
+
+    MatMultArgs local = local_args((MatMultArgs *)arg);
+    MatMultArgs *args = &local;
+    const Kernels *kern = get_kernels();
+    const size_t cols = (size_t)args->C->cols;
+
+    switch (args->C->type) 
+    {
+        case MATRIX_INT64:  elements_i64(args, first, last); return;
+        case MATRIX_FLOAT:  elements_f32(args, first, last); return;
+        case MATRIX_DOUBLE: elements_f64(args, first, last); return;
+        default: break;
+    }
+    for (size_t idx = first; idx < last; idx++) 
+    {
+        compute_element(kern, args, (int)(idx / cols), (int)(idx % cols));
+    }
+}
+
+// Method 4: output tiles [first, last) of C, numbered row-major over the tile grid.
+// Inside a tile the loop order is i-k-j, so B and C are read along rows with unit
+// stride; k is blocked by tile_l2 and rows/k again by tile_l1 so the strip of B
+// being reused stays in L1 while the tile's block of B stays in L2.
+void multiply_tiles(void *arg, size_t first, size_t last) {
+
+    TileMultArgs local = *(TileMultArgs *)arg;
+    if (local.B_nodes) local.B = local.B_nodes[current_node()];
+    TileMultArgs *args = &local;
+    const Kernels *kern = get_kernels();
+    const Matrix *A = args->A;
+    const Matrix *B = args->B;
+    Matrix *C = args->C;
+    const int t2 = args->tile_l2;
+    const int t1 = args->tile_l1;
+    const size_t tiles_across = ((size_t)C->cols + t2 - 1) / t2;
+
+    switch (C->type) 
+    {
+        case MATRIX_INT64:  tiles_i64(args, first, last); return;
+        case MATRIX_FLOAT:  tiles_f32(args, first, last); return;
+        case MATRIX_DOUBLE: tiles_f64(args, first, last); return;
+        default: break;
+    }
+    for (size_t t = first; t < last; t++) 
+    {
+        // Bounds of this output tile
+        const int i0 = (int)(t / tiles_across) * t2;
+        const int j0 = (int)(t % tiles_across) * t2;
+        const int i_end = i0 + t2 < C->rows ? i0 + t2 : C->rows;
+        const int j_end = j0 + t2 < C->cols ? j0 + t2 : C->cols;
+
+        // The tile starts from zero and accumulates one k block at a time
+        for (int i = i0; i < i_end; i++) 
+        {
+            int *c = MAT_ROW(C, i);
+            for (int j = j0; j < j_end; j++) c[j] = 0;
+        }
+
+        for (int k0 = 0; k0 < A->cols; k0 += t2) // L2 block of k
+        {
+            const int k_end = k0 + t2 < A->cols ? k0 + t2 : A->cols;
+            for (int i1 = i0; i1 < i_end; i1 += t1) // L1 block of rows
+            {
+                const int i1_end = i1 + t1 < i_end ? i1 + t1 : i_end;
+                for (int k1 = k0; k1 < k_end; k1 += t1) // L1 block of k
+                {
+                    const int k1_end = k1 + t1 < k_end ? k1 + t1 : k_end;
+                    for (int i = i1; i < i1_end; i++) 
+                    {
+                        const int *a = MAT_ROW(A, i);
+                        int *c = MAT_ROW(C, i);
+                        for (int k = k1; k < k1_end; k++) // Unit stride over B and C
+                        {
+                            kern->axpy(c + j0, a[k], MAT_ROW(B, k) + j0, j_end - j0);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+//------------------------------
+// Packing
+//------------------------------
+
+// Edge of the square blocks copied by the transpose (32x32 ints = 4 KiB per side)
+#define PACK_BLOCK 32
+
+typedef struct {
+    const Matrix *src;
+    Matrix *dst;
+} PackArgs;
+
+// Transpose column blocks [first, last) of src (each PACK_BLOCK columns wide) into dst,
+// one PACK_BLOCK x PACK_BLOCK square at a time so reads and writes both stay in cache
+static void pack_blocks(void *arg, size_t first, size_t last) {
+
+    PackArgs *args = (PackArgs *)arg;
+    const Matrix *src = args->src;
+    Matrix *dst = args->dst;
+
+    for (size_t blk = first; blk < last; blk++) 
+    {
+        const int j0 = (int)blk * PACK_BLOCK;
+        const int j_end = j0 + PACK_BLOCK < src->cols ? j0 + PACK_BLOCK : src->cols;
+        for (int i0 = 0; i0 < src->rows; i0 += PACK_BLOCK) 
+        {
+            const int i_end = i0 + PACK_BLOCK < src->rows ? i0 + PACK_BLOCK : src->rows;
+            for (int j = j0; j < j_end; j++) 
+            {
+                int *out = MAT_ROW(dst, j);
+                for (int i = i0; i < i_end; i++) 
+                {
+                    out[i] = MAT_ROW(src, i)[j];
+                }
+            }
+        }
+    }
+}
+
+Matrix *pack_transposed(ThreadPool *pool, const Matrix *B) {
+
+    Matrix *Bt = create_matrix(B->cols, B->rows);
+    PackArgs args = { B, Bt };
+    size_t blocks = ((size_t)B->cols + PACK_BLOCK - 1) / PACK_BLOCK;
+
+    TaskGroup group = { 0 };
+    pool_submit_range_group(pool, &group, pack_blocks, &args, 0, blocks, 1);
+    pool_group_wait(pool, &group); // args lives on this stack frame
+    return Bt;
+}
+
+//------------------------------
+// Task Submission
+//------------------------------
+
+void submit_per_matrix(ThreadPool *pool, MatMultArgs *args) {
+
+    if (args->group) pool_submit_group(pool, args->group, multiply_matrix, args);
+    else pool_submit(pool, multiply_matrix, args);
+}
+
+void submit_per_row(ThreadPool *pool, MatMultArgs *args) {
+
+    pool_submit_range_group(pool, args->group, multiply_rows, args, 0, (size_t)args->C->rows, 1);
+}
+
+void submit_per_element(ThreadPool *pool, MatMultArgs *args) {
+
+    pool_submit_range_group(pool, args->group, multiply_elements, args, 0, (size_t)args->C->rows * args->C->cols, 1);
+}
+
+void submit_per_tile(ThreadPool *pool, TileMultArgs *args) {
+
+    // Unset (or invalid) tile sizes fall back to the defaults; the L1 block never exceeds the L2 tile
+    if (args->tile_l2 <= 0) args->tile_l2 = DEFAULT_TILE_L2;
+    if (args->tile_l1 <= 0) args->tile_l1 = DEFAULT_TILE_L1;
+    if (args->tile_l1 > args->tile_l2) args->tile_l1 = args->tile_l2;
+
+    size_t tiles_down = ((size_t)args->C->rows + args->tile_l2 - 1) / args->tile_l2;
+    size_t tiles_across = ((size_t)args->C->cols + args->tile_l2 - 1) / args->tile_l2;
+    pool_submit_range_group(pool, args->group, multiply_tiles, args, 0, tiles_down * tiles_across, 1);
+}
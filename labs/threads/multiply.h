@@ -0,0 +1,57 @@
+#ifndef MULTIPLY_H
+#define MULTIPLY_H
+
+#include "matrix.h"
+#include "pool.h"
+
+//------------------------------
+// Structure for Task Arguments
+//------------------------------
+
+// Operands of one product C = A x B. A single instance is shared (read-only)
+// by every task of a method and must stay alive until pool_wait() returns.
+typedef struct {
+    Matrix *A;
+    Matrix *B;
+    Matrix *C;
+    Matrix *Bt;    // B packed column-major by pack_transposed(), or NULL to walk B's columns
+    Matrix **B_nodes;    // Per-node copies of B and Bt (replicate_per_node()), or NULL to
+    Matrix **Bt_nodes;   // share B and Bt: each task reads the copy on its worker's node
+    TaskGroup *group;    // Counts the method's tasks, so it can be waited for alone (NULL: none)
+} MatMultArgs;
+
+// Default tile edges for method 4, in elements
+#define DEFAULT_TILE_L2 128   // Output tile and k block: a 128x128 int block of B is 64 KiB (L2)
+#define DEFAULT_TILE_L1 32    // Inner block: a 32x128 int strip of B is 16 KiB (L1)
+
+// For method 4 (cache-blocked output tiles). Shared by all tile tasks like MatMultArgs.
+typedef struct {
+    Matrix *A;
+    Matrix *B;
+    Matrix *C;
+    int tile_l2;   // Edge of an output tile of C and of each k block
+    int tile_l1;   // Edge of the row and k sub-blocks walked inside a tile
+    Matrix **B_nodes;   // Per-node copies of B, or NULL (as in MatMultArgs)
+    TaskGroup *group;   // As in MatMultArgs
+} TileMultArgs;
+
+// Task bodies
+void multiply_matrix(void *arg);                                // Whole product in one task
+void multiply_rows(void *arg, size_t first, size_t last);       // Rows [first, last) of C
+void multiply_elements(void *arg, size_t first, size_t last);   // Row-major elements [first, last) of C
+void multiply_tiles(void *arg, size_t first, size_t last);      // Row-major output tiles [first, last) of C
+
+// Column-major copy of B (B transposed), built in parallel on the pool and
+// shared read-only by every task so row and element kernels read B with unit stride
+Matrix *pack_transposed(ThreadPool *pool, const Matrix *B);
+
+// Queue a method's work on the pool; pool_wait() marks completion (or, with a group
+// in the arguments, pool_group_wait() on it marks this method's).
+// Rows and elements are submitted as one range each and are only split down
+// to single rows / single elements while there are idle workers to take them.
+void submit_per_matrix(ThreadPool *pool, MatMultArgs *args);
+void submit_per_row(ThreadPool *pool, MatMultArgs *args);
+void submit_per_element(ThreadPool *pool, MatMultArgs *args);
+void submit_per_tile(ThreadPool *pool, TileMultArgs *args);
+
+#endif
@@ -0,0 +1,347 @@
+#define _GNU_SOURCE  // CPU_SET(), sched_getaffinity(), pthread_setaffinity_np()
+#include <stdio.h>   // Standard I/O functions
+#include <stdlib.h>  // Memory management
+#include <string.h>  // memset(), memcpy()
+#include <stdint.h>  // uint64_t
+#include <dirent.h>  // Listing the nodes in sysfs
+#include <sched.h>   // cpu_set_t
+#include <pthread.h> // pthread_setaffinity_np(), barriers
+#include <time.h>    // clock_gettime()
+#include "placement.h"
+
+#define NODE_SYSFS "/sys/devices/system/node"
+
+// Node index of the calling worker, set when it is pinned
+static __thread int worker_node_index;
+
+int current_node(void) {
+
+    return worker_node_index;
+}
+
+//------------------------------
+// Topology
+//------------------------------
+
+// Parse a sysfs CPU list such as "0-3,8-11" into set
+static void parse_cpulist(const char *text, cpu_set_t *set) {
+
+    CPU_ZERO(set);
+    const char *p = text;
+    while (*p >= '0' && *p <= '9') 
+    {
+        char *end;
+        long first = strtol(p, &end, 10), last = first;
+        if (*end == '-') last = strtol(end + 1, &end, 10);
+        for (long cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++) CPU_SET((int)cpu, set);
+        p = *end == ',' ? end + 1 : end;
+    }
+}
+
+// CPUs of node id, or -1 when sysfs does not describe it
+static int read_node_cpus(int id, cpu_set_t *set) {
+
+    char path[128], text[4096];
+    snprintf(path, sizeof(path), NODE_SYSFS "/node%d/cpulist", id);
+    FILE *fp = fopen(path, "r");
+    if (!fp) 
+    {
+        return -1;
+    }
+    size_t len = fread(text, 1, sizeof(text) - 1, fp);
+    fclose(fp);
+    text[len] = '\0';
+    parse_cpulist(text, set);
+    return 0;
+}
+
+// System ids of the nodes listed in sysfs, ascending; returns the count
+static int list_nodes(int *ids, int max) {
+
+    int count = 0;
+    DIR *dir = opendir(NODE_SYSFS);
+    if (!dir) 
+    {
+        return 0;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL && count < max) 
+    {
+        int id;
+        char extra;
+        if (sscanf(entry->d_name, "node%d%c", &id, &extra) == 1) ids[count++] = id;
+    }
+    closedir(dir);
+
+    for (int t = 1; t < count; t++) // Insertion sort: a handful of nodes
+    {
+        int id = ids[t], u = t;
+        for (; u > 0 && ids[u - 1] > id; u--) ids[u] = ids[u - 1];
+        ids[u] = id;
+    }
+    return count;
+}
+
+static void pin_one(void *arg, size_t worker) {
+
+    const Placement *place = (const Placement *)arg;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(place->worker_cpu[worker], &set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) 
+    {
+        fprintf(stderr, "Warning: could not pin worker %zu to CPU %d\n", worker, place->worker_cpu[worker]);
+    }
+    worker_node_index = place->worker_node[worker];
+}
+
+// Allowed CPUs in node order; workers take them in turn (wrapping when there are
+// more workers than CPUs). CPUs that sysfs places on no node join the first node.
+Placement *pin_workers(ThreadPool *pool) {
+
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) 
+    {
+        perror("sched_getaffinity");
+        exit(EXIT_FAILURE);
+    }
+
+    int node_ids[CPU_SETSIZE];
+    int num_listed = list_nodes(node_ids, CPU_SETSIZE);
+
+    Placement *place = calloc(1, sizeof(Placement));
+    int *cpus = malloc(CPU_SETSIZE * sizeof(int));
+    int *cpu_node = malloc(CPU_SETSIZE * sizeof(int));
+    if (place) 
+    {
+        place->node_ids = malloc(((size_t)num_listed + 1) * sizeof(int));
+        place->worker_cpu = malloc(pool->num_workers * sizeof(int));
+        place->worker_node = malloc(pool->num_workers * sizeof(int));
+    }
+    if (!place || !cpus || !cpu_node || !place->node_ids || !place->worker_cpu || !place->worker_node) 
+    {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+
+    // Group the allowed CPUs by node, keeping only nodes that have some
+    int num_cpus = 0;
+    cpu_set_t placed;
+    CPU_ZERO(&placed);
+    for (int n = 0; n < num_listed; n++) 
+    {
+        cpu_set_t node_cpus;
+        if (read_node_cpus(node_ids[n], &node_cpus) != 0) continue;
+        const int before = num_cpus;
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) 
+        {
+            if (!CPU_ISSET(cpu, &node_cpus) || !CPU_ISSET(cpu, &allowed) || CPU_ISSET(cpu, &placed)) continue;
+            CPU_SET(cpu, &placed);
+            cpu_node[num_cpus] = place->num_nodes;
+            cpus[num_cpus++] = cpu;
+        }
+        if (num_cpus > before) place->node_ids[place->num_nodes++] = node_ids[n];
+    }
+    if (place->num_nodes == 0) // No NUMA information: one node
+    {
+        place->node_ids[place->num_nodes++] = 0;
+    }
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) 
+    {
+        if (!CPU_ISSET(cpu, &allowed) || CPU_ISSET(cpu, &placed)) continue;
+        cpu_node[num_cpus] = 0;
+        cpus[num_cpus++] = cpu;
+    }
+
+    for (size_t w = 0; w < pool->num_workers; w++) 
+    {
+        place->worker_cpu[w] = cpus[w % num_cpus];
+        place->worker_node[w] = cpu_node[w % num_cpus];
+    }
+    free(cpus);
+    free(cpu_node);
+
+    pool_run_on_each(pool, pin_one, place);
+    return place;
+}
+
+void free_placement(Placement *place) {
+
+    if (!place) return;
+    free(place->node_ids);
+    free(place->worker_cpu);
+    free(place->worker_node);
+    free(place);
+}
+
+//------------------------------
+// First Touch
+//------------------------------
+
+typedef struct {
+    ThreadPool *pool;
+    const Placement *place;   // NULL: the rows are split over all workers
+    const Matrix *src;        // Copied into the destination, or NULL to zero it
+    Matrix *dst;              // The destination when place is NULL
+    Matrix **copies;          // Otherwise one destination per node
+} TouchJob;
+
+// Position of worker among the workers of its node, and their count
+static void node_rank(const Placement *place, size_t num_workers, size_t worker, size_t *rank, size_t *count) {
+
+    *rank = 0;
+    *count = 0;
+    for (size_t w = 0; w < num_workers; w++) 
+    {
+        if (place->worker_node[w] != place->worker_node[worker]) continue;
+        if (w < worker) (*rank)++;
+        (*count)++;
+    }
+}
+
+// Rows [rows*part/parts, rows*(part+1)/parts) of dst, zeroed or copied from src
+static void touch_rows(Matrix *dst, const Matrix *src, size_t part, size_t parts) {
+
+    const size_t row_bytes = (size_t)dst->stride * matrix_type_size(dst->type);
+    const size_t first = (size_t)dst->rows * part / parts;
+    const size_t last = (size_t)dst->rows * (part + 1) / parts;
+    char *out = (char *)dst->data + first * row_bytes;
+
+    if (!src) 
+    {
+        memset(out, 0, (last - first) * row_bytes);
+        return;
+    }
+    const size_t elem_size = matrix_type_size(src->type);
+    for (size_t i = first; i < last; i++, out += row_bytes) // src may be a mapped file with its own stride
+    {
+        memcpy(out, (const char *)src->data + i * src->stride * elem_size, (size_t)src->cols * elem_size);
+    }
+}
+
+static void touch_part(void *arg, size_t worker) {
+
+    TouchJob *job = (TouchJob *)arg;
+    if (!job->place) 
+    {
+        touch_rows(job->dst, job->src, worker, job->pool->num_workers);
+        return;
+    }
+    size_t rank, count;
+    node_rank(job->place, job->pool->num_workers, worker, &rank, &count);
+    touch_rows(job->copies[job->place->worker_node[worker]], job->src, rank, count);
+}
+
+Matrix *create_matrix_placed(ThreadPool *pool, int rows, int cols, MatrixType type) {
+
+    TouchJob job = { .pool = pool, .dst = allocate_matrix(rows, cols, type) };
+    pool_run_on_each(pool, touch_part, &job);
+    return job.dst;
+}
+
+Matrix **replicate_per_node(ThreadPool *pool, const Placement *place, const Matrix *src) {
+
+    if (place->num_nodes <= 1) 
+    {
+        return NULL;
+    }
+    Matrix **copies = malloc((size_t)place->num_nodes * sizeof(Matrix *));
+    if (!copies) 
+    {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    for (int n = 0; n < place->num_nodes; n++) 
+    {
+        copies[n] = allocate_matrix(src->rows, src->cols, src->type);
+    }
+    TouchJob job = { .pool = pool, .place = place, .src = src, .copies = copies };
+    pool_run_on_each(pool, touch_part, &job); // Each node's workers copy into its own replica
+    return copies;
+}
+
+void free_replicas(Matrix **copies, const Placement *place) {
+
+    if (!copies) return;
+    for (int n = 0; n < place->num_nodes; n++) free_matrix(copies[n]);
+    free(copies);
+}
+
+//------------------------------
+// Bandwidth
+//------------------------------
+
+typedef struct {
+    ThreadPool *pool;
+    const Placement *place;
+    pthread_barrier_t start;   // Every worker has touched its buffer
+    double *seconds;           // Per worker
+    size_t *bytes;             // Per worker
+    uint64_t *sums;            // Per worker, so the reads are not optimised away
+} BandwidthJob;
+
+static double now_seconds(void) {
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void read_share(void *arg, size_t worker) {
+
+    BandwidthJob *job = (BandwidthJob *)arg;
+    size_t rank, count;
+    node_rank(job->place, job->pool->num_workers, worker, &rank, &count);
+
+    const size_t words = NODE_BANDWIDTH_BYTES / count / sizeof(uint64_t);
+    uint64_t *buf = malloc(words * sizeof(uint64_t) + 1);
+    if (!buf) 
+    {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < words; i++) buf[i] = i; // First touch: the pages land on our node
+
+    pthread_barrier_wait(&job->start);
+    const double t0 = now_seconds();
+    uint64_t sum = 0;
+    for (size_t i = 0; i < words; i++) sum += buf[i];
+    job->seconds[worker] = now_seconds() - t0;
+    job->bytes[worker] = words * sizeof(uint64_t);
+    job->sums[worker] = sum;
+    free(buf);
+}
+
+void measure_node_bandwidth(ThreadPool *pool, const Placement *place, double *gbps) {
+
+    const size_t n = pool->num_workers;
+    BandwidthJob job = { .pool = pool, .place = place };
+    job.seconds = calloc(n, sizeof(double));
+    job.bytes = calloc(n, sizeof(size_t));
+    job.sums = calloc(n, sizeof(uint64_t));
+    if (!job.seconds || !job.bytes || !job.sums) 
+    {
+        perror("calloc");
+        exit(EXIT_FAILURE);
+    }
+    pthread_barrier_init(&job.start, NULL, (unsigned)n);
+    pool_run_on_each(pool, read_share, &job);
+    pthread_barrier_destroy(&job.start);
+
+    // A node's rate: everything its workers read over the time the slowest one took
+    for (int node = 0; node < place->num_nodes; node++) 
+    {
+        double slowest = 0;
+        size_t bytes = 0;
+        for (size_t w = 0; w < n; w++) 
+        {
+            if (place->worker_node[w] != node) continue;
+            if (job.seconds[w] > slowest) slowest = job.seconds[w];
+            bytes += job.bytes[w];
+        }
+        gbps[node] = slowest > 0 ? bytes / slowest / 1e9 : 0;
+    }
+    free(job.seconds);
+    free(job.bytes);
+    free(job.sums);
+}
@@ -0,0 +1,37 @@
+#ifndef PLACEMENT_H
+#define PLACEMENT_H
+
+#include "matrix.h"
+#include "pool.h"
+
+// Bytes each node streams through when its read bandwidth is measured
+#define NODE_BANDWIDTH_BYTES (256u << 20)
+
+// Where the workers of a pool run. Workers are pinned one per allowed CPU, the CPUs
+// taken node by node, so workers 0..k-1 share a node, k..2k-1 the next one, and so on.
+typedef struct {
+    int num_nodes;       // Memory nodes with at least one worker (1 without NUMA)
+    int *node_ids;       // System id of each of those nodes
+    int *worker_cpu;     // CPU each worker is pinned to
+    int *worker_node;    // Index into node_ids of that CPU's node
+} Placement;
+
+// Function prototypes
+Placement *pin_workers(ThreadPool *pool);      // Reads the topology from sysfs and pins every worker
+void free_placement(Placement *place);
+int current_node(void);                        // Node index of the calling pinned worker (0 elsewhere)
+
+// NUMA placement (--numa): with the pool's ranges spread (pool_set_spread), worker w
+// owns rows [rows*w/N, rows*(w+1)/N) of every C. create_matrix_placed() lets each
+// worker zero its own rows, so first touch puts them on its node; replicate_per_node()
+// gives every node its own copy of a read-only operand (NULL with a single node,
+// where all workers share the original). free_replicas() takes the same count.
+Matrix *create_matrix_placed(ThreadPool *pool, int rows, int cols, MatrixType type);
+Matrix **replicate_per_node(ThreadPool *pool, const Placement *place, const Matrix *src);
+void free_replicas(Matrix **copies, const Placement *place);
+
+// Read bandwidth of each node in GB/s, all nodes measured at once: every worker
+// sums its share of a NODE_BANDWIDTH_BYTES buffer that it first touched itself
+void measure_node_bandwidth(ThreadPool *pool, const Placement *place, double *gbps);
+
+#endif
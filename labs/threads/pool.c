@@ -0,0 +1,481 @@
+#include <stdio.h>   // Standard I/O functions
+#include <stdlib.h>  // Memory management
+#include <unistd.h>  // sysconf() for the number of online CPUs
+#include <sched.h>   // sched_yield() while a group wait finds nothing to run
+#include "pool.h"
+
+// Initial number of task slots in each worker's deque
+#define DEQUE_INITIAL_CAPACITY 64
+
+// Pool and worker index of the calling thread (NULL / 0 outside any pool)
+static __thread ThreadPool *current_pool;
+static __thread size_t current_worker;
+
+// Number of CPUs currently online (at least 1)
+size_t online_cpus(void) {
+
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    return online > 0 ? (size_t)online : 1;
+}
+
+//------------------------------
+// Deque Operations
+//------------------------------
+
+// Owner end: append at the bottom, growing the buffer when full
+static void deque_push(Deque *dq, Task task) {
+
+    pthread_mutex_lock(&dq->mutex);
+    if (dq->count == dq->capacity) 
+    {
+        Task *bigger = malloc(2 * dq->capacity * sizeof(Task));
+        if (!bigger) 
+        {
+            perror("malloc");
+            exit(EXIT_FAILURE);
+        }
+        for (size_t t = 0; t < dq->count; t++) // Unroll so the oldest task lands at index 0
+        {
+            bigger[t] = dq->tasks[(dq->top + t) % dq->capacity];
+        }
+        free(dq->tasks);
+        dq->tasks = bigger;
+        dq->capacity *= 2;
+        dq->top = 0;
+    }
+    dq->tasks[(dq->top + dq->count) % dq->capacity] = task;
+    dq->count++;
+    pthread_mutex_unlock(&dq->mutex);
+}
+
+// Owner end: take the newest task
+static int deque_pop(Deque *dq, Task *task) {
+
+    int found = 0;
+    pthread_mutex_lock(&dq->mutex);
+    if (dq->count > 0) 
+    {
+        dq->count--;
+        *task = dq->tasks[(dq->top + dq->count) % dq->capacity];
+        found = 1;
+    }
+    pthread_mutex_unlock(&dq->mutex);
+    return found;
+}
+
+// Thief end: take the oldest task
+static int deque_steal(Deque *dq, Task *task) {
+
+    int found = 0;
+    if (pthread_mutex_trylock(&dq->mutex) != 0) // Busy deque: try another victim instead of queueing up
+    {
+        return 0;
+    }
+    if (dq->count > 0) 
+    {
+        *task = dq->tasks[dq->top];
+        dq->top = (dq->top + 1) % dq->capacity;
+        dq->count--;
+        found = 1;
+    }
+    pthread_mutex_unlock(&dq->mutex);
+    return found;
+}
+
+//------------------------------
+// Scheduling
+//------------------------------
+
+// Queue a task on `target`'s deque and wake a sleeping worker
+static void push_task(ThreadPool *pool, size_t target, Task task) {
+
+    atomic_fetch_add(&pool->pending, 1);
+    if (task.group) atomic_fetch_add(&task.group->pending, 1);
+    deque_push(&pool->deques[target], task);
+    atomic_fetch_add(&pool->queued, 1);
+
+    pthread_mutex_lock(&pool->mutex);
+    pthread_cond_signal(&pool->task_available);
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+// Own deque first, then every other worker's deque starting after our own
+static int find_task(ThreadPool *pool, size_t self, Task *task) {
+
+    if (deque_pop(&pool->deques[self], task)) 
+    {
+        atomic_fetch_sub(&pool->queued, 1);
+        return 1;
+    }
+    for (size_t v = 1; v < pool->num_workers; v++) 
+    {
+        if (deque_steal(&pool->deques[(self + v) % pool->num_workers], task)) 
+        {
+            atomic_fetch_sub(&pool->queued, 1);
+            atomic_fetch_add(&pool->steals, 1);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Run one task. A range task is processed one grain at a time; whenever some
+// worker is idle and our own deque is empty, the unprocessed upper half is
+// split off onto our deque where it can be stolen. With no idle workers the
+// range runs in one piece.
+static void run_task(ThreadPool *pool, size_t self, Task *task) {
+
+    if (task->fn) 
+    {
+        task->fn(task->arg);
+    } 
+    else 
+    {
+        size_t first = task->first;
+        size_t last = task->last;
+        while (first < last) 
+        {
+            if (last - first > task->grain && atomic_load(&pool->idle) > 0
+                && atomic_load_explicit(&pool->deques[self].count, memory_order_relaxed) == 0) 
+            {
+                size_t middle = first + (last - first) / 2;
+                Task upper = *task;
+                upper.first = middle;
+                upper.last = last;
+                push_task(pool, self, upper);
+                atomic_fetch_add(&pool->splits, 1);
+                last = middle;
+                continue;
+            }
+            size_t stop = last - first > task->grain ? first + task->grain : last;
+            task->range_fn(task->arg, first, stop);
+            first = stop;
+        }
+    }
+
+    // Wake pool_group_wait() callers outside the pool when a group completes
+    if (task->group && atomic_fetch_sub(&task->group->pending, 1) == 1) 
+    {
+        pthread_mutex_lock(&pool->mutex);
+        pthread_cond_broadcast(&pool->all_tasks_done);
+        pthread_mutex_unlock(&pool->mutex);
+    }
+
+    // Wake pool_wait() when the last outstanding task completes
+    if (atomic_fetch_sub(&pool->pending, 1) == 1) 
+    {
+        pthread_mutex_lock(&pool->mutex);
+        pthread_cond_broadcast(&pool->all_tasks_done);
+        pthread_mutex_unlock(&pool->mutex);
+    }
+}
+
+// Worker loop: run local work, steal when out of it, sleep when nothing is queued anywhere
+static void *pool_worker(void *arg) {
+
+    Deque *own = (Deque *)arg;
+    ThreadPool *pool = own->pool;
+    size_t self = (size_t)(own - pool->deques); // Our index is our deque's position
+
+    current_pool = pool;
+    current_worker = self;
+
+    int is_idle = 0;
+    while (1) 
+    {
+        Task task;
+        if (find_task(pool, self, &task)) 
+        {
+            if (is_idle) 
+            {
+                is_idle = 0;
+                atomic_fetch_sub(&pool->idle, 1);
+            }
+            run_task(pool, self, &task);
+            continue;
+        }
+
+        // Out of work: advertise idleness so busy workers start splitting
+        if (!is_idle) 
+        {
+            is_idle = 1;
+            atomic_fetch_add(&pool->idle, 1);
+        }
+
+        // Sleep until something is queued somewhere (or the pool shuts down)
+        pthread_mutex_lock(&pool->mutex);
+        while (atomic_load(&pool->queued) == 0 && !pool->shutting_down) 
+        {
+            pthread_cond_wait(&pool->task_available, &pool->mutex);
+        }
+        int stop = pool->shutting_down && atomic_load(&pool->queued) == 0;
+        pthread_mutex_unlock(&pool->mutex);
+        if (stop) 
+        {
+            break;
+        }
+    }
+    if (is_idle) 
+    {
+        atomic_fetch_sub(&pool->idle, 1);
+    }
+    return NULL;
+}
+
+//------------------------------
+// Public Interface
+//------------------------------
+
+// Start a pool of num_workers threads that live until free_pool()
+ThreadPool *create_pool(size_t num_workers) {
+
+    ThreadPool *pool = calloc(1, sizeof(ThreadPool));
+    if (!pool) 
+    {
+        perror("calloc");
+        exit(EXIT_FAILURE);
+    }
+
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->task_available, NULL);
+    pthread_cond_init(&pool->all_tasks_done, NULL);
+
+    pool->num_workers = num_workers > 0 ? num_workers : online_cpus();
+    pool->workers = malloc(pool->num_workers * sizeof(pthread_t));
+    pool->deques = calloc(pool->num_workers, sizeof(Deque));
+    if (!pool->workers || !pool->deques) 
+    {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t w = 0; w < pool->num_workers; w++) 
+    {
+        Deque *dq = &pool->deques[w];
+        pthread_mutex_init(&dq->mutex, NULL);
+        dq->pool = pool;
+        dq->capacity = DEQUE_INITIAL_CAPACITY;
+        dq->tasks = malloc(dq->capacity * sizeof(Task));
+        if (!dq->tasks) 
+        {
+            perror("malloc");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // Create every worker once; they are reused for all submitted tasks
+    for (size_t w = 0; w < pool->num_workers; w++) 
+    {
+        if (pthread_create(&pool->workers[w], NULL, pool_worker, &pool->deques[w]) != 0) 
+        {
+            perror("pthread_create");
+            exit(EXIT_FAILURE);
+        }
+    }
+    return pool;
+}
+
+// Deque that receives a new task: the caller's own when it is one of our workers,
+// otherwise the next deque in round-robin order
+static size_t submit_target(ThreadPool *pool) {
+
+    if (current_pool == pool) 
+    {
+        return current_worker;
+    }
+    return atomic_fetch_add(&pool->next_deque, 1) % pool->num_workers;
+}
+
+// Queue fn(arg) as one indivisible task
+void pool_submit(ThreadPool *pool, void (*fn)(void *arg), void *arg) {
+
+    Task task = { .fn = fn, .arg = arg };
+    push_task(pool, submit_target(pool), task);
+}
+
+// Queue fn(arg, ...) over [first, last); idle workers make it split down to `grain` units
+void pool_submit_range(ThreadPool *pool, RangeFn fn, void *arg,
+                       size_t first, size_t last, size_t grain) {
+
+    pool_submit_range_group(pool, NULL, fn, arg, first, last, grain);
+}
+
+// The same as a member of group: every piece split off the range counts toward it
+void pool_submit_range_group(ThreadPool *pool, TaskGroup *group, RangeFn fn, void *arg,
+                             size_t first, size_t last, size_t grain) {
+
+    if (first >= last) 
+    {
+        return;
+    }
+    Task task = { .range_fn = fn, .arg = arg, .first = first, .last = last,
+                  .grain = grain > 0 ? grain : 1, .group = group };
+    if (pool->spread_ranges && current_pool != pool) 
+    {
+        // Slice w is [first + n*w/N, first + n*(w+1)/N), the same split every time
+        const size_t n = last - first;
+        for (size_t w = 0; w < pool->num_workers; w++) 
+        {
+            task.first = first + n * w / pool->num_workers;
+            task.last = first + n * (w + 1) / pool->num_workers;
+            if (task.first < task.last) push_task(pool, w, task);
+        }
+        return;
+    }
+    push_task(pool, submit_target(pool), task);
+}
+
+// Block until every task submitted so far (and every piece split from it) has finished
+void pool_wait(ThreadPool *pool) {
+
+    pthread_mutex_lock(&pool->mutex);
+    while (atomic_load(&pool->pending) > 0) 
+    {
+        pthread_cond_wait(&pool->all_tasks_done, &pool->mutex);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+// Queue fn(arg) as a member of group; pool_group_wait(pool, group) waits for it
+void pool_submit_group(ThreadPool *pool, TaskGroup *group, void (*fn)(void *arg), void *arg) {
+
+    Task task = { .fn = fn, .arg = arg, .group = group };
+    push_task(pool, submit_target(pool), task);
+}
+
+// Block until every task of group has finished. A worker of this pool does not
+// sleep: it keeps running queued tasks (its own first, so usually the group's),
+// which lets tasks wait for tasks they spawned without tying up workers.
+void pool_group_wait(ThreadPool *pool, TaskGroup *group) {
+
+    if (current_pool == pool) 
+    {
+        while (atomic_load(&group->pending) > 0) 
+        {
+            Task task;
+            if (find_task(pool, current_worker, &task)) 
+            {
+                run_task(pool, current_worker, &task);
+            }
+            else 
+            {
+                sched_yield(); // The rest of the group is running on other workers
+            }
+        }
+        return;
+    }
+
+    pthread_mutex_lock(&pool->mutex);
+    while (atomic_load(&group->pending) > 0) 
+    {
+        pthread_cond_wait(&pool->all_tasks_done, &pool->mutex);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+size_t pool_group_wait_any(ThreadPool *pool, TaskGroup *const *groups, size_t n) {
+
+    pthread_mutex_lock(&pool->mutex);
+    while (1) 
+    {
+        for (size_t g = 0; g < n; g++) 
+        {
+            if (atomic_load(&groups[g]->pending) == 0) 
+            {
+                pthread_mutex_unlock(&pool->mutex);
+                return g;
+            }
+        }
+        pthread_cond_wait(&pool->all_tasks_done, &pool->mutex); // Broadcast whenever a group completes
+    }
+}
+
+size_t pool_worker_index(ThreadPool *pool) {
+
+    return current_pool == pool ? current_worker : pool->num_workers;
+}
+
+void *pool_scratch(size_t bytes) {
+
+    if (!current_pool) 
+    {
+        return NULL;
+    }
+    Deque *dq = &current_pool->deques[current_worker];
+    if (dq->scratch_size < bytes) 
+    {
+        free(dq->scratch); // Nothing in it is kept from one task to the next
+        dq->scratch = malloc(bytes);
+        if (!dq->scratch) 
+        {
+            perror("malloc");
+            exit(EXIT_FAILURE);
+        }
+        dq->scratch_size = bytes;
+    }
+    return dq->scratch;
+}
+
+typedef struct {
+    void (*fn)(void *arg, size_t worker);
+    void *arg;
+    pthread_barrier_t barrier;
+} EachWorker;
+
+static void run_on_worker(void *arg) {
+
+    EachWorker *each = (EachWorker *)arg;
+    each->fn(each->arg, current_worker);
+    pthread_barrier_wait(&each->barrier); // Hold this worker until every other one has taken a task
+}
+
+// One task per worker; since each task blocks until all of them have run, no
+// worker can take a second one, wherever the tasks were queued or stolen
+void pool_run_on_each(ThreadPool *pool, void (*fn)(void *arg, size_t worker), void *arg) {
+
+    EachWorker each = { fn, arg };
+    pthread_barrier_init(&each.barrier, NULL, (unsigned)pool->num_workers);
+    for (size_t w = 0; w < pool->num_workers; w++) 
+    {
+        Task task = { .fn = run_on_worker, .arg = &each };
+        push_task(pool, w, task);
+    }
+    pool_wait(pool);
+    pthread_barrier_destroy(&each.barrier);
+}
+
+void pool_set_spread(ThreadPool *pool, int spread) {
+
+    pool->spread_ranges = spread;
+}
+
+// Finish queued work, stop and join the workers, release the pool
+void free_pool(ThreadPool *pool) {
+
+    if (!pool) 
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->shutting_down = 1;
+    pthread_cond_broadcast(&pool->task_available);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (size_t w = 0; w < pool->num_workers; w++) 
+    {
+        pthread_join(pool->workers[w], NULL);
+    }
+
+    for (size_t w = 0; w < pool->num_workers; w++) 
+    {
+        pthread_mutex_destroy(&pool->deques[w].mutex);
+        free(pool->deques[w].tasks);
+        free(pool->deques[w].scratch);
+    }
+    pthread_mutex_destroy(&pool->mutex);
+    pthread_cond_destroy(&pool->task_available);
+    pthread_cond_destroy(&pool->all_tasks_done);
+    free(pool->deques);
+    free(pool->workers);
+    free(pool);
+}
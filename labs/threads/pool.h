@@ -0,0 +1,94 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+
+// Body of a range task: processes units [first, last) of some index space
+typedef void (*RangeFn)(void *arg, size_t first, size_t last);
+
+// Completion counter for a set of tasks, so a task can wait for the tasks it
+// spawned (fork-join) without waiting for everything queued on the pool
+typedef struct {
+    atomic_size_t pending;  // Tasks of the group queued or running (split pieces included)
+} TaskGroup;
+
+// A unit of work. Plain tasks run fn(arg) once; range tasks run range_fn over
+// [first, last) and may be split in halves while other workers are idle.
+typedef struct {
+    void (*fn)(void *arg);  // Plain task body (NULL for range tasks)
+    RangeFn range_fn;       // Range task body (NULL for plain tasks)
+    void *arg;              // Shared argument passed to the body
+    size_t first;           // First unit of the range
+    size_t last;            // One past the last unit of the range
+    size_t grain;           // Smallest range that is worth splitting off
+    TaskGroup *group;       // Counted down when the task finishes (NULL if none)
+} Task;
+
+// Per-worker double-ended queue: the owner pushes and pops at the bottom (LIFO),
+// thieves take from the top (FIFO), so stolen work is the oldest and largest.
+typedef struct {
+    struct pool *pool;      // Pool that owns this deque (its worker's start argument)
+    pthread_mutex_t mutex;  // Protects the fields below
+    Task *tasks;            // Circular buffer (grows on demand)
+    size_t capacity;        // Slots in tasks
+    size_t top;             // Index of the oldest task (steal end)
+    atomic_size_t count;    // Number of queued tasks (also read without the lock as a hint)
+    void *scratch;          // The worker's reusable scratch memory (pool_scratch())
+    size_t scratch_size;
+} Deque;
+
+struct pool {
+    size_t num_workers;             // Number of worker threads
+    pthread_t *workers;             // Worker thread identifiers
+    Deque *deques;                  // One deque per worker
+    atomic_size_t pending;          // Queued tasks plus tasks currently running
+    atomic_size_t queued;           // Tasks sitting in any deque
+    atomic_size_t idle;             // Workers that found no task to run
+    atomic_size_t steals;           // Tasks taken from another worker's deque
+    atomic_size_t splits;           // Range tasks split in two to feed idle workers
+    atomic_size_t next_deque;       // Round-robin target for submissions from outside the pool
+    pthread_mutex_t mutex;          // Guards sleeping, waiting and shutdown
+    pthread_cond_t task_available;  // Signaled when a task is queued or the pool shuts down
+    pthread_cond_t all_tasks_done;  // Signaled when the last outstanding task, or a task group, finishes
+    int shutting_down;              // Set by free_pool(): workers exit once all deques drain
+    int spread_ranges;              // Ranges submitted from outside start as one slice per worker
+};
+
+typedef struct pool ThreadPool;
+
+// Function prototypes
+ThreadPool *create_pool(size_t num_workers);   // 0 = one worker per online CPU
+void pool_submit(ThreadPool *pool, void (*fn)(void *arg), void *arg);
+void pool_submit_range(ThreadPool *pool, RangeFn fn, void *arg,
+                       size_t first, size_t last, size_t grain);
+void pool_wait(ThreadPool *pool);
+void pool_submit_group(ThreadPool *pool, TaskGroup *group, void (*fn)(void *arg), void *arg);
+void pool_submit_range_group(ThreadPool *pool, TaskGroup *group, RangeFn fn, void *arg,
+                             size_t first, size_t last, size_t grain);
+void pool_group_wait(ThreadPool *pool, TaskGroup *group);  // Workers run other tasks meanwhile
+
+// Block until at least one of groups[0..n) has no tasks left and return its index
+// (the lowest, if several have). Call from outside the pool.
+size_t pool_group_wait_any(ThreadPool *pool, TaskGroup *const *groups, size_t n);
+void free_pool(ThreadPool *pool);
+size_t pool_worker_index(ThreadPool *pool);  // Calling worker's index, or num_workers outside the pool
+
+// At least bytes of scratch memory private to the calling worker, kept (and grown
+// when too small) across tasks and runs and freed with the pool, so task bodies need
+// no allocation of their own. NULL outside any pool. The contents do not survive
+// into the next task: do not hold it across a pool_group_wait().
+void *pool_scratch(size_t bytes);
+
+// Run fn(arg, worker) exactly once on every worker and wait for all of them.
+// Call from outside the pool with nothing else queued.
+void pool_run_on_each(ThreadPool *pool, void (*fn)(void *arg, size_t worker), void *arg);
+
+// With spread set, a range submitted from outside the pool is queued as num_workers
+// contiguous slices, slice w on worker w's deque (stealing still balances them), so
+// the same units keep going to the same worker: see placement.h.
+void pool_set_spread(ThreadPool *pool, int spread);
+size_t online_cpus(void);
+
+#endif
@@ -0,0 +1,306 @@
+#include <stdio.h>   // Standard I/O functions
+#include <stdlib.h>  // Memory management
+#include <string.h>  // memset()
+#include "sparse.h"
+#include "kernels.h"
+
+// Work pieces per worker: enough for stealing to even out the remainder
+#define PIECES_PER_WORKER 8
+
+//------------------------------
+// Construction
+//------------------------------
+
+static SparseMatrix *alloc_sparse(int rows, int cols, size_t nnz) {
+
+    SparseMatrix *mat = malloc(sizeof(SparseMatrix));
+    if (mat) 
+    {
+        mat->rows = rows;
+        mat->cols = cols;
+        mat->nnz = nnz;
+        mat->row_ptr = calloc((size_t)rows + 1, sizeof(size_t));
+        mat->col_idx = malloc((nnz + 1) * sizeof(int));
+        mat->values = malloc((nnz + 1) * sizeof(int));
+    }
+    if (!mat || !mat->row_ptr || !mat->col_idx || !mat->values) 
+    {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    return mat;
+}
+
+void free_sparse_matrix(SparseMatrix *mat) {
+
+    if (!mat) return;
+    free(mat->row_ptr);
+    free(mat->col_idx);
+    free(mat->values);
+    free(mat);
+}
+
+// Entries in any order, repeated positions added up, explicit zeros dropped
+SparseMatrix *sparse_from_entries(int rows, int cols, const MatrixEntry *entries, size_t count) {
+
+    // Bucket the entries by row (counting sort), then sum each row through a dense
+    // scratch row that also records which columns it has touched
+    size_t *start = calloc((size_t)rows + 1, sizeof(size_t));
+    size_t *order = malloc((count + 1) * sizeof(size_t));
+    unsigned *acc = calloc((size_t)cols, sizeof(unsigned));
+    int *touched = malloc(((size_t)cols + 1) * sizeof(int));
+    char *seen = calloc((size_t)cols, 1);
+    if (!start || !order || !acc || !touched || !seen) 
+    {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t e = 0; e < count; e++) start[entries[e].row + 1]++;
+    for (int i = 0; i < rows; i++) start[i + 1] += start[i];
+    for (size_t e = 0; e < count; e++) order[start[entries[e].row]++] = e;
+    for (int i = rows; i > 0; i--) start[i] = start[i - 1]; // Undo the increments
+    start[0] = 0;
+
+    SparseMatrix *mat = alloc_sparse(rows, cols, count);
+    size_t nnz = 0;
+    for (int i = 0; i < rows; i++) 
+    {
+        int n_touched = 0;
+        for (size_t o = start[i]; o < start[i + 1]; o++) 
+        {
+            const MatrixEntry *entry = &entries[order[o]];
+            if (!seen[entry->col]) 
+            {
+                seen[entry->col] = 1;
+                touched[n_touched++] = entry->col;
+            }
+            acc[entry->col] += (unsigned)entry->value;
+        }
+
+        // Touched columns in ascending order (insertion sort: rows are short)
+        for (int t = 1; t < n_touched; t++) 
+        {
+            int col = touched[t], u = t;
+            for (; u > 0 && touched[u - 1] > col; u--) touched[u] = touched[u - 1];
+            touched[u] = col;
+        }
+        for (int t = 0; t < n_touched; t++) 
+        {
+            const int col = touched[t];
+            if (acc[col] != 0) 
+            {
+                mat->col_idx[nnz] = col;
+                mat->values[nnz] = (int)acc[col];
+                nnz++;
+            }
+            acc[col] = 0;
+            seen[col] = 0;
+        }
+        mat->row_ptr[i + 1] = nnz;
+    }
+    mat->nnz = nnz;
+
+    free(start);
+    free(order);
+    free(acc);
+    free(touched);
+    free(seen);
+    return mat;
+}
+
+size_t count_nonzeros(const Matrix *mat) {
+
+    size_t nnz = 0;
+    for (int i = 0; i < mat->rows; i++) 
+    {
+        const int *row = MAT_ROW(mat, i);
+        for (int j = 0; j < mat->cols; j++) nnz += (row[j] != 0);
+    }
+    return nnz;
+}
+
+SparseMatrix *sparse_from_dense(const Matrix *mat) {
+
+    SparseMatrix *sp = alloc_sparse(mat->rows, mat->cols, count_nonzeros(mat));
+    size_t nnz = 0;
+    for (int i = 0; i < mat->rows; i++) 
+    {
+        const int *row = MAT_ROW(mat, i);
+        for (int j = 0; j < mat->cols; j++) 
+        {
+            if (row[j] == 0) continue;
+            sp->col_idx[nnz] = j;
+            sp->values[nnz] = row[j];
+            nnz++;
+        }
+        sp->row_ptr[i + 1] = nnz;
+    }
+    return sp;
+}
+
+int load_sparse_operand(const char *filename, ThreadPool *pool, SparseMatrix **sparse, Matrix **dense) {
+
+    *sparse = NULL;
+    *dense = NULL;
+
+    int rows, cols;
+    MatrixEntry *entries;
+    size_t count;
+    int kind = read_matrix_entries(filename, &rows, &cols, &entries, &count);
+    if (kind < 0) 
+    {
+        return -1;
+    }
+    if (kind == 1) 
+    {
+        *sparse = sparse_from_entries(rows, cols, entries, count);
+        free(entries);
+        return 0;
+    }
+
+    Matrix *mat = read_matrix_from_file(filename, pool);
+    if (!mat) 
+    {
+        return -1;
+    }
+    if ((double)count_nonzeros(mat) <= SPARSE_MAX_DENSITY * mat->rows * mat->cols) 
+    {
+        *sparse = sparse_from_dense(mat);
+        free_matrix(mat);
+    }
+    else 
+    {
+        *dense = mat;
+    }
+    return 0;
+}
+
+//------------------------------
+// Multiplication
+//------------------------------
+
+typedef struct {
+    const SpmmArgs *args;
+    const size_t *bounds;   // Piece p covers rows [bounds[p], bounds[p + 1])
+} SpmmJob;
+
+// Row i of C for a sparse A: each nonzero a_ik adds a_ik times row k of B
+static void sparse_row(const Kernels *kern, const SpmmArgs *args, int i) {
+
+    const SparseMatrix *A = args->A_sparse;
+    int *c = MAT_ROW(args->C, i);
+
+    for (size_t e = A->row_ptr[i]; e < A->row_ptr[i + 1]; e++) 
+    {
+        const int a = A->values[e];
+        const int k = A->col_idx[e];
+        if (args->B) // Dense row of B: vector kernel
+        {
+            kern->axpy(c, a, MAT_ROW(args->B, k), args->C->cols);
+        }
+        else // Sparse row of B: scatter into the dense row of C
+        {
+            const SparseMatrix *B = args->B_sparse;
+            for (size_t f = B->row_ptr[k]; f < B->row_ptr[k + 1]; f++) 
+            {
+                unsigned *dst = (unsigned *)&c[B->col_idx[f]];
+                *dst += (unsigned)a * (unsigned)B->values[f];
+            }
+        }
+    }
+}
+
+// Row i of C for a dense A and sparse B: skip the zeros of A's row
+static void dense_row(const SpmmArgs *args, int i) {
+
+    const SparseMatrix *B = args->B_sparse;
+    const int *a = MAT_ROW(args->A, i);
+    unsigned *c = (unsigned *)MAT_ROW(args->C, i);
+
+    for (int k = 0; k < args->A->cols; k++) 
+    {
+        if (a[k] == 0) continue;
+        for (size_t f = B->row_ptr[k]; f < B->row_ptr[k + 1]; f++) 
+        {
+            c[B->col_idx[f]] += (unsigned)a[k] * (unsigned)B->values[f];
+        }
+    }
+}
+
+static void multiply_pieces(void *arg, size_t first, size_t last) {
+
+    SpmmJob *job = (SpmmJob *)arg;
+    const Kernels *kern = get_kernels();
+
+    for (size_t p = first; p < last; p++) 
+    {
+        for (size_t i = job->bounds[p]; i < job->bounds[p + 1]; i++) 
+        {
+            memset(MAT_ROW(job->args->C, i), 0, (size_t)job->args->C->cols * sizeof(int));
+            if (job->args->A_sparse) sparse_row(kern, job->args, (int)i);
+            else dense_row(job->args, (int)i);
+        }
+    }
+}
+
+// Multiply-adds needed for row i of C (plus one so empty rows still count)
+static size_t row_work(const SpmmArgs *args, int i) {
+
+    size_t work = 1;
+    if (args->A_sparse) 
+    {
+        const SparseMatrix *A = args->A_sparse;
+        for (size_t e = A->row_ptr[i]; e < A->row_ptr[i + 1]; e++) 
+        {
+            const int k = A->col_idx[e];
+            work += args->B ? (size_t)args->B->cols
+                            : args->B_sparse->row_ptr[k + 1] - args->B_sparse->row_ptr[k];
+        }
+    }
+    else 
+    {
+        const int *a = MAT_ROW(args->A, i);
+        const SparseMatrix *B = args->B_sparse;
+        for (int k = 0; k < args->A->cols; k++) 
+        {
+            if (a[k] != 0) work += B->row_ptr[k + 1] - B->row_ptr[k];
+        }
+    }
+    return work;
+}
+
+void multiply_sparse(ThreadPool *pool, SpmmArgs *args) {
+
+    const int rows = args->C->rows;
+
+    // Prefix sums of the work per row
+    size_t *prefix = malloc(((size_t)rows + 1) * sizeof(size_t));
+    size_t pieces = pool->num_workers * PIECES_PER_WORKER;
+    if (pieces > (size_t)rows) pieces = (size_t)rows;
+    size_t *bounds = malloc((pieces + 1) * sizeof(size_t));
+    if (!prefix || !bounds) 
+    {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    prefix[0] = 0;
+    for (int i = 0; i < rows; i++) prefix[i + 1] = prefix[i] + row_work(args, i);
+
+    // Piece p starts at the first row whose preceding work reaches p / pieces of the total
+    const size_t total = prefix[rows];
+    size_t row = 0;
+    for (size_t p = 0; p < pieces; p++) 
+    {
+        const size_t target = (size_t)((double)total * p / pieces);
+        while (row < (size_t)rows && prefix[row] < target) row++;
+        bounds[p] = row;
+    }
+    bounds[pieces] = (size_t)rows;
+
+    SpmmJob job = { args, bounds };
+    pool_submit_range(pool, multiply_pieces, &job, 0, pieces, 1);
+    pool_wait(pool);
+
+    free(prefix);
+    free(bounds);
+}
@@ -0,0 +1,47 @@
+#ifndef SPARSE_H
+#define SPARSE_H
+
+#include <stddef.h>
+#include "matrix.h"
+#include "pool.h"
+
+// Dense inputs at or below this fraction of nonzeros are converted to CSR
+#define SPARSE_MAX_DENSITY 0.25
+
+// Compressed sparse row matrix: the nonzeros of row i are
+// col_idx/values[row_ptr[i] .. row_ptr[i + 1]), in ascending column order.
+typedef struct {
+    int rows;
+    int cols;
+    size_t nnz;
+    size_t *row_ptr;   // rows + 1 offsets
+    int *col_idx;
+    int *values;
+} SparseMatrix;
+
+// Operands of C = A x B on the sparse path: each input is given either sparse or
+// dense (the other pointer NULL), but not both dense. C is dense and fully overwritten.
+typedef struct {
+    const SparseMatrix *A_sparse;
+    const Matrix *A;
+    const SparseMatrix *B_sparse;
+    const Matrix *B;
+    Matrix *C;
+} SpmmArgs;
+
+// Function prototypes
+SparseMatrix *sparse_from_entries(int rows, int cols, const MatrixEntry *entries, size_t count);
+SparseMatrix *sparse_from_dense(const Matrix *mat);
+void free_sparse_matrix(SparseMatrix *mat);
+size_t count_nonzeros(const Matrix *mat);
+
+// Loads a matrix for the sparse path: a sparse file always becomes CSR; a dense file
+// becomes CSR when its density is at most SPARSE_MAX_DENSITY and stays dense otherwise.
+// Exactly one of *sparse / *dense is set on success; returns -1 on error.
+int load_sparse_operand(const char *filename, ThreadPool *pool, SparseMatrix **sparse, Matrix **dense);
+
+// C = A x B in parallel, with rows of C grouped into pieces of equal multiply-add
+// count (from the nonzeros per row) rather than equal row count. Blocks until done.
+void multiply_sparse(ThreadPool *pool, SpmmArgs *args);
+
+#endif
@@ -0,0 +1,437 @@
+#include <stdio.h>   // Standard I/O functions
+#include <stdlib.h>  // Memory management
+#include <string.h>  // memcpy()
+#include "strassen.h"
+#include "multiply.h"
+
+// Levels are bounded by the int dimensions
+#define MAX_LEVELS 31
+
+//------------------------------
+// Scratch Arenas
+//------------------------------
+
+// Bump allocator over one block. Sequential recursion takes a mark on entry and
+// rewinds to it on exit, so every level reuses the same memory.
+typedef struct {
+    char *base;
+    size_t size;
+    size_t used;
+} Arena;
+
+// Bytes of a rows x cols block laid out like create_matrix (a multiple of MATRIX_ALIGN)
+static size_t block_bytes(int rows, int cols) {
+
+    const int ints_per_line = MATRIX_ALIGN / sizeof(int);
+    size_t stride = ((size_t)cols + ints_per_line - 1) / ints_per_line * ints_per_line;
+    return (size_t)rows * stride * sizeof(int);
+}
+
+static void arena_init(Arena *arena, size_t size) {
+
+    arena->size = size;
+    arena->used = 0;
+    arena->base = size ? aligned_alloc(MATRIX_ALIGN, size) : NULL;
+    if (size && !arena->base) 
+    {
+        perror("aligned_alloc");
+        exit(EXIT_FAILURE);
+    }
+}
+
+// A rows x cols scratch block from the arena (contents undefined)
+static Matrix arena_block(Arena *arena, int rows, int cols) {
+
+    const int ints_per_line = MATRIX_ALIGN / sizeof(int);
+    size_t bytes = block_bytes(rows, cols);
+    if (arena->used + bytes > arena->size) 
+    {
+        fprintf(stderr, "Error: Strassen scratch arena exhausted.\n");
+        exit(EXIT_FAILURE);
+    }
+    Matrix m = { rows, cols, (cols + ints_per_line - 1) / ints_per_line * ints_per_line,
+                 (int *)(arena->base + arena->used), NULL, 0 };
+    arena->used += bytes;
+    return m;
+}
+
+//------------------------------
+// Block Helpers
+//------------------------------
+
+// Quadrant (qi, qj) of an even-sized matrix, as a view sharing its storage
+static Matrix quadrant(const Matrix *m, int qi, int qj) {
+
+    const int rows = m->rows / 2, cols = m->cols / 2;
+    Matrix q = { rows, cols, m->stride, MAT_ROW(m, qi * rows) + qj * cols, NULL, 0 };
+    return q;
+}
+
+// dst = x + sign * y (modulo 2^32, like the kernels)
+static void combine(Matrix *dst, const Matrix *x, const Matrix *y, int sign) {
+
+    for (int i = 0; i < dst->rows; i++) 
+    {
+        int *d = MAT_ROW(dst, i);
+        const int *a = MAT_ROW(x, i);
+        const int *b = MAT_ROW(y, i);
+        if (sign > 0) 
+        {
+            for (int j = 0; j < dst->cols; j++) d[j] = (int)((unsigned)a[j] + (unsigned)b[j]);
+        }
+        else 
+        {
+            for (int j = 0; j < dst->cols; j++) d[j] = (int)((unsigned)a[j] - (unsigned)b[j]);
+        }
+    }
+}
+
+// dst += sign * x, or dst = x when sign is 0
+static void accumulate(Matrix *dst, const Matrix *x, int sign) {
+
+    for (int i = 0; i < dst->rows; i++) 
+    {
+        int *d = MAT_ROW(dst, i);
+        const int *a = MAT_ROW(x, i);
+        if (sign == 0) 
+        {
+            memcpy(d, a, (size_t)dst->cols * sizeof(int));
+        }
+        else if (sign > 0) 
+        {
+            for (int j = 0; j < dst->cols; j++) d[j] = (int)((unsigned)d[j] + (unsigned)a[j]);
+        }
+        else 
+        {
+            for (int j = 0; j < dst->cols; j++) d[j] = (int)((unsigned)d[j] - (unsigned)a[j]);
+        }
+    }
+}
+
+//------------------------------
+// The Seven Products
+//------------------------------
+// M1 = (A11 + A22)(B11 + B22)    C11 = M1 + M4 - M5 + M7
+// M2 = (A21 + A22) B11           C12 = M3 + M5
+// M3 = A11 (B12 - B22)           C21 = M2 + M4
+// M4 = A22 (B21 - B11)           C22 = M1 - M2 + M3 + M6
+// M5 = (A11 + A12) B22
+// M6 = (A21 - A11)(B11 + B12)
+// M7 = (A12 - A22)(B21 + B22)
+
+// Operands of product i: quadrants (row, col) of A and B and the sign joining a
+// second quadrant (0: the first quadrant is used on its own)
+typedef struct {
+    int a1, a2, a_sign;   // Quadrants numbered 0..3 as 11, 12, 21, 22
+    int b1, b2, b_sign;
+} ProductTerms;
+
+static const ProductTerms products[7] = {
+    { 0, 3, +1,  0, 3, +1 },   // M1
+    { 2, 3, +1,  0, 0,  0 },   // M2
+    { 0, 0,  0,  1, 3, -1 },   // M3
+    { 3, 3,  0,  2, 0, -1 },   // M4
+    { 0, 1, +1,  3, 3,  0 },   // M5
+    { 2, 0, -1,  0, 1, +1 },   // M6
+    { 1, 3, -1,  2, 3, +1 },   // M7
+};
+
+// Sign of product i in each quadrant of C (0: not used)
+static const int c_terms[4][7] = {
+    { +1, 0, 0, +1, -1, 0, +1 },   // C11
+    { 0, 0, +1, 0, +1, 0, 0 },     // C12
+    { 0, +1, 0, +1, 0, 0, 0 },     // C21
+    { +1, -1, +1, 0, 0, +1, 0 },   // C22
+};
+
+//------------------------------
+// Recursion
+//------------------------------
+
+typedef struct {
+    ThreadPool *pool;
+    int levels;                        // Halvings from the full product down to the leaves
+    int parallel_levels;               // Top levels whose products are separate tasks
+    int tile_l2, tile_l1;
+    char *node_scratch;                // Blocks of every parallel node, laid out by level and index
+    size_t level_offset[MAX_LEVELS];   // Start of each parallel level in node_scratch
+    size_t node_bytes[MAX_LEVELS];     // Scratch of one node on that level
+    Arena *worker_arenas;              // One per worker, allocated on first use
+    size_t worker_arena_bytes;
+} Strassen;
+
+// Operand blocks of one product (a view or a sum), and the product block itself
+typedef struct {
+    Strassen *s;
+    Matrix A, B, C;                    // Quadrant views of the parent
+    const ProductTerms *terms;
+    Matrix TA, TB, P;                  // Scratch for the operand sums and the product
+    int level;                         // Level of the product P
+    size_t index;                      // Index of P among the nodes of its level
+} ProductTask;
+
+static void multiply_node(Strassen *s, Matrix *A, Matrix *B, Matrix *C, int level, size_t index);
+
+// The kernel at the leaves: tiled, sequential within the calling task
+static void multiply_leaf(Strassen *s, Matrix *A, Matrix *B, Matrix *C) {
+
+    TileMultArgs args = { A, B, C, s->tile_l2, s->tile_l1 };
+    size_t tiles_down = ((size_t)C->rows + s->tile_l2 - 1) / s->tile_l2;
+    size_t tiles_across = ((size_t)C->cols + s->tile_l2 - 1) / s->tile_l2;
+    multiply_tiles(&args, 0, tiles_down * tiles_across);
+}
+
+// Left and right operands of a product: a quadrant, or the sum formed in scratch
+static void form_operands(const Matrix *A, const Matrix *B, const ProductTerms *t,
+                          Matrix *TA, Matrix *TB, Matrix *left, Matrix *right) {
+
+    Matrix a1 = quadrant(A, t->a1 / 2, t->a1 % 2), a2 = quadrant(A, t->a2 / 2, t->a2 % 2);
+    Matrix b1 = quadrant(B, t->b1 / 2, t->b1 % 2), b2 = quadrant(B, t->b2 / 2, t->b2 % 2);
+    if (t->a_sign) 
+    {
+        combine(TA, &a1, &a2, t->a_sign);
+        *left = *TA;
+    }
+    else 
+    {
+        *left = a1;
+    }
+    if (t->b_sign) 
+    {
+        combine(TB, &b1, &b2, t->b_sign);
+        *right = *TB;
+    }
+    else 
+    {
+        *right = b1;
+    }
+}
+
+// Deep levels: the seven products one after another inside the calling task.
+// Each product is added into C as soon as it is known, so a level needs only one
+// A sum, one B sum and one product block from the arena.
+static void multiply_sequential(Strassen *s, Arena *arena, Matrix *A, Matrix *B, Matrix *C, int level) {
+
+    if (level == s->levels) 
+    {
+        multiply_leaf(s, A, B, C);
+        return;
+    }
+
+    const size_t mark = arena->used;
+    Matrix TA = arena_block(arena, A->rows / 2, A->cols / 2);
+    Matrix TB = arena_block(arena, B->rows / 2, B->cols / 2);
+    Matrix P = arena_block(arena, C->rows / 2, C->cols / 2);
+    int written[4] = { 0, 0, 0, 0 }; // Quadrants of C are assigned by their first product
+
+    for (int i = 0; i < 7; i++) 
+    {
+        Matrix left, right;
+        form_operands(A, B, &products[i], &TA, &TB, &left, &right);
+        multiply_sequential(s, arena, &left, &right, &P, level + 1);
+
+        for (int q = 0; q < 4; q++) 
+        {
+            if (!c_terms[q][i]) continue;
+            Matrix cq = quadrant(C, q / 2, q % 2);
+            accumulate(&cq, &P, written[q] ? c_terms[q][i] : 0); // First terms are all +1
+            written[q] = 1;
+        }
+    }
+    arena->used = mark;
+}
+
+// Body of a parallel product: form its operands, then recurse
+static void run_product(void *arg) {
+
+    ProductTask *task = (ProductTask *)arg;
+    Matrix left, right;
+    form_operands(&task->A, &task->B, task->terms, &task->TA, &task->TB, &left, &right);
+    multiply_node(task->s, &left, &right, &task->P, task->level, task->index);
+}
+
+// One quadrant of C from the seven products of a parallel node
+typedef struct {
+    Matrix C;
+    const Matrix *P;
+    int q;
+} QuadrantTask;
+
+static void run_quadrant(void *arg) {
+
+    QuadrantTask *task = (QuadrantTask *)arg;
+    int written = 0;
+    for (int i = 0; i < 7; i++) 
+    {
+        if (!c_terms[task->q][i]) continue;
+        accumulate(&task->C, &task->P[i], written ? c_terms[task->q][i] : 0);
+        written = 1;
+    }
+}
+
+// C = A x B for the node `index` of `level`. Parallel levels spawn the seven
+// products and then the four quadrant sums as task groups; the levels below run
+// sequentially on the calling worker's arena.
+static void multiply_node(Strassen *s, Matrix *A, Matrix *B, Matrix *C, int level, size_t index) {
+
+    if (level >= s->parallel_levels) 
+    {
+        size_t w = pool_worker_index(s->pool);
+        Arena *arena = &s->worker_arenas[w];
+        if (!arena->base) arena_init(arena, s->worker_arena_bytes);
+        multiply_sequential(s, arena, A, B, C, level);
+        return;
+    }
+
+    // This node's scratch: 7 products, 5 A sums and 5 B sums (M2-M5 use a quadrant as is)
+    Arena scratch = { s->node_scratch + s->level_offset[level] + index * s->node_bytes[level],
+                      s->node_bytes[level], 0 };
+    ProductTask tasks[7];
+    Matrix P[7];
+    TaskGroup group = { 0 };
+    for (int i = 0; i < 7; i++) 
+    {
+        ProductTask *t = &tasks[i];
+        t->s = s;
+        t->A = *A;
+        t->B = *B;
+        t->C = *C;
+        t->terms = &products[i];
+        if (products[i].a_sign) t->TA = arena_block(&scratch, A->rows / 2, A->cols / 2);
+        if (products[i].b_sign) t->TB = arena_block(&scratch, B->rows / 2, B->cols / 2);
+        t->P = arena_block(&scratch, C->rows / 2, C->cols / 2);
+        t->level = level + 1;
+        t->index = index * 7 + (size_t)i;
+        P[i] = t->P;
+        pool_submit_group(s->pool, &group, run_product, t);
+    }
+    pool_group_wait(s->pool, &group);
+
+    QuadrantTask quads[4];
+    for (int q = 0; q < 4; q++) 
+    {
+        quads[q] = (QuadrantTask){ quadrant(C, q / 2, q % 2), P, q };
+        pool_submit_group(s->pool, &group, run_quadrant, &quads[q]);
+    }
+    pool_group_wait(s->pool, &group);
+}
+
+// Root task: the node scratch and arenas are set up, run level 0
+typedef struct {
+    Strassen *s;
+    Matrix *A, *B, *C;
+} RootTask;
+
+static void run_root(void *arg) {
+
+    RootTask *root = (RootTask *)arg;
+    multiply_node(root->s, root->A, root->B, root->C, 0, 0);
+}
+
+//------------------------------
+// Entry Point
+//------------------------------
+
+// Zero-padded copy of m with the given dimensions (or m itself when they match)
+static Matrix *padded(Matrix *m, int rows, int cols) {
+
+    if (m->rows == rows && m->cols == cols) return m;
+    Matrix *p = create_matrix(rows, cols);
+    for (int i = 0; i < m->rows; i++) 
+    {
+        memcpy(MAT_ROW(p, i), MAT_ROW(m, i), (size_t)m->cols * sizeof(int));
+    }
+    return p;
+}
+
+void multiply_strassen(ThreadPool *pool, StrassenArgs *args) {
+
+    const int cutoff = args->cutoff <= 0 ? DEFAULT_STRASSEN_CUTOFF
+                     : args->cutoff < MIN_STRASSEN_CUTOFF ? MIN_STRASSEN_CUTOFF : args->cutoff;
+    const int M = args->A->rows, K = args->A->cols, N = args->B->cols;
+
+    Strassen s = { .pool = pool,
+                   .tile_l2 = args->tile_l2 > 0 ? args->tile_l2 : DEFAULT_TILE_L2,
+                   .tile_l1 = args->tile_l1 > 0 ? args->tile_l1 : DEFAULT_TILE_L1 };
+    if (s.tile_l1 > s.tile_l2) s.tile_l1 = s.tile_l2;
+
+    // Halve until the smallest dimension is down to the cutoff
+    int smallest = M < K ? (M < N ? M : N) : (K < N ? K : N);
+    while (smallest > cutoff && s.levels < MAX_LEVELS - 1) 
+    {
+        smallest = (smallest + 1) / 2;
+        s.levels++;
+    }
+    if (s.levels == 0) // Too small to recurse: the plain tiled method 
+    {
+        TileMultArgs tile = { args->A, args->B, args->C, s.tile_l2, s.tile_l1 };
+        submit_per_tile(pool, &tile);
+        pool_wait(pool);
+        return;
+    }
+
+    // Pad every dimension to a multiple of 2^levels so each level halves exactly
+    const int unit = 1 << s.levels;
+    const int Mp = (M + unit - 1) / unit * unit;
+    const int Kp = (K + unit - 1) / unit * unit;
+    const int Np = (N + unit - 1) / unit * unit;
+    Matrix *A = padded(args->A, Mp, Kp);
+    Matrix *B = padded(args->B, Kp, Np);
+    Matrix *C = (Mp == M && Np == N) ? args->C : create_matrix(Mp, Np);
+
+    // Spawn products as tasks until there are at least as many as workers
+    size_t nodes = 1;
+    size_t total = 0;
+    while (s.parallel_levels < s.levels && nodes < pool->num_workers) 
+    {
+        const int l = s.parallel_levels;
+        const int m = Mp >> (l + 1), k = Kp >> (l + 1), n = Np >> (l + 1);
+        s.node_bytes[l] = 5 * block_bytes(m, k) + 5 * block_bytes(k, n) + 7 * block_bytes(m, n);
+        s.level_offset[l] = total;
+        total += nodes * s.node_bytes[l];
+        nodes *= 7;
+        s.parallel_levels++;
+    }
+    s.node_scratch = total ? aligned_alloc(MATRIX_ALIGN, total) : NULL;
+    if (total && !s.node_scratch) 
+    {
+        perror("aligned_alloc");
+        exit(EXIT_FAILURE);
+    }
+
+    // A worker's arena holds one A sum, one B sum and one product per sequential level
+    for (int l = s.parallel_levels; l < s.levels; l++) 
+    {
+        const int m = Mp >> (l + 1), k = Kp >> (l + 1), n = Np >> (l + 1);
+        s.worker_arena_bytes += block_bytes(m, k) + block_bytes(k, n) + block_bytes(m, n);
+    }
+    s.worker_arenas = calloc(pool->num_workers, sizeof(Arena));
+    if (!s.worker_arenas) 
+    {
+        perror("calloc");
+        exit(EXIT_FAILURE);
+    }
+
+    RootTask root = { &s, A, B, C };
+    TaskGroup group = { 0 };
+    pool_submit_group(pool, &group, run_root, &root);
+    pool_group_wait(pool, &group);
+
+    // Crop the padding back off
+    if (C != args->C) 
+    {
+        for (int i = 0; i < M; i++) 
+        {
+            memcpy(MAT_ROW(args->C, i), MAT_ROW(C, i), (size_t)N * sizeof(int));
+        }
+        free_matrix(C);
+    }
+    if (A != args->A) free_matrix(A);
+    if (B != args->B) free_matrix(B);
+    for (size_t w = 0; w < pool->num_workers; w++) 
+    {
+        free(s.worker_arenas[w].base);
+    }
+    free(s.worker_arenas);
+    free(s.node_scratch);
+}
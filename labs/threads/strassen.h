@@ -0,0 +1,29 @@
+#ifndef STRASSEN_H
+#define STRASSEN_H
+
+#include "matrix.h"
+#include "pool.h"
+
+// Products whose smallest dimension is at or below the cutoff use the tiled kernel
+#define DEFAULT_STRASSEN_CUTOFF 256
+#define MIN_STRASSEN_CUTOFF 16
+
+// For method 5 (Strassen recursion over the tiled kernel)
+typedef struct {
+    Matrix *A;
+    Matrix *B;
+    Matrix *C;
+    int cutoff;    // Recurse while every dimension is above this (0 = default)
+    int tile_l2;   // Tile edges of the kernel used at the leaves (0 = defaults)
+    int tile_l1;
+} StrassenArgs;
+
+// C = A x B by Strassen's seven-product recursion. The top levels run their seven
+// products as separate pool tasks; deeper levels recurse inside one task using a
+// per-worker scratch arena, so no level allocates. Dimensions are zero-padded to a
+// multiple of 2^levels when they do not halve evenly. Integer arithmetic wraps
+// modulo 2^32, so the result is identical to the other methods.
+// Blocks until C is complete.
+void multiply_strassen(ThreadPool *pool, StrassenArgs *args);
+
+#endif
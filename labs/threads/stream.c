@@ -0,0 +1,317 @@
+#include <stdio.h>   // Standard I/O functions
+#include <stdlib.h>  // Memory management
+#include <string.h>  // String management
+#include <unistd.h>  // mkstemp(), unlink()
+#include <pthread.h> // Background panel reads and writes
+#include "stream.h"
+#include "matrix.h"
+#include "kernels.h"
+
+//------------------------------
+// Panel I/O on Helper Threads
+//------------------------------
+
+// One panel read or write, run on its own thread while the pool computes.
+// Reads fill rows [0, nrows) x columns [0, ncols) of panel from (row0, col0).
+typedef struct {
+    pthread_t thread;
+    int running;
+    int status;
+    MatrixReader *reader;   // Set for reads
+    MatrixWriter *writer;   // Set for writes
+    Matrix *panel;
+    int row0, nrows, col0, ncols;
+} PanelIO;
+
+static void *panel_io_main(void *arg) {
+
+    PanelIO *io = (PanelIO *)arg;
+    if (io->reader) 
+    {
+        io->status = read_matrix_block(io->reader, io->row0, io->nrows, io->col0, io->ncols,
+                                       io->panel->data, io->panel->stride);
+    }
+    else 
+    {
+        io->status = write_matrix_rows(io->writer, io->panel->data, io->panel->stride, io->nrows);
+    }
+    return NULL;
+}
+
+static void start_io(PanelIO *io) {
+
+    if (pthread_create(&io->thread, NULL, panel_io_main, io) != 0) 
+    {
+        perror("pthread_create");
+        exit(EXIT_FAILURE);
+    }
+    io->running = 1;
+}
+
+// Wait for the panel's transfer; returns its status (0 if none was running)
+static int finish_io(PanelIO *io) {
+
+    if (!io->running) return 0;
+    pthread_join(io->thread, NULL);
+    io->running = 0;
+    return io->status;
+}
+
+static void start_read(PanelIO *io, MatrixReader *r, Matrix *panel, int row0, int nrows, int col0, int ncols) {
+
+    *io = (PanelIO){ .reader = r, .panel = panel, .row0 = row0, .nrows = nrows, .col0 = col0, .ncols = ncols };
+    start_io(io);
+}
+
+static void start_write(PanelIO *io, MatrixWriter *w, Matrix *panel, int nrows) {
+
+    *io = (PanelIO){ .writer = w, .panel = panel, .nrows = nrows };
+    start_io(io);
+}
+
+//------------------------------
+// Panel Product
+//------------------------------
+
+// C panel columns [c0, c0 + B->cols) = A panel x B panel
+typedef struct {
+    const Matrix *A;   // Row panel of A (all of its columns)
+    const Matrix *B;   // Column panel of B (all of its rows)
+    Matrix *C;         // Row panel of C (all of its columns)
+    int c0;
+} PanelArgs;
+
+static void multiply_panel_rows(void *arg, size_t first, size_t last) {
+
+    PanelArgs *args = (PanelArgs *)arg;
+    const Kernels *kern = get_kernels();
+
+    for (size_t i = first; i < last; i++) 
+    {
+        kern->row(MAT_ROW(args->A, i), args->B->data, (size_t)args->B->stride,
+                  MAT_ROW(args->C, i) + args->c0, args->B->cols, args->A->cols);
+    }
+}
+
+//------------------------------
+// Planning
+//------------------------------
+
+static size_t panel_bytes(int rows, int cols) {
+
+    const int ints_per_line = MATRIX_ALIGN / sizeof(int);
+    size_t stride = ((size_t)cols + ints_per_line - 1) / ints_per_line * ints_per_line;
+    return (size_t)rows * stride * sizeof(int);
+}
+
+// Choose the B panel width pc and the A/C panel height pr for an M x K times K x N
+// product within budget. B gets up to half the budget (all of B, loaded once, when it
+// fits; otherwise two panels in flight); two A panels and two C panels share the rest.
+static int plan_panels(int M, int K, int N, size_t budget, int *pr, int *pc) {
+
+    const int ints_per_line = MATRIX_ALIGN / sizeof(int);
+    size_t b_bytes;
+    if (panel_bytes(K, N) <= budget / 2) 
+    {
+        *pc = N;
+        b_bytes = panel_bytes(K, N);
+    }
+    else 
+    {
+        size_t cols = budget / 2 / 2 / panel_bytes(K, 1) * ints_per_line; // panel_bytes(K, 1) covers one line of columns
+        if (cols == 0) return -1;
+        *pc = cols < (size_t)N ? (int)cols : N;
+        b_bytes = 2 * panel_bytes(K, *pc);
+    }
+
+    size_t row_bytes = 2 * (panel_bytes(1, K) + panel_bytes(1, N)); // Two A rows and two C rows
+    size_t rows = budget > b_bytes ? (budget - b_bytes) / row_bytes : 0;
+    if (rows == 0) return -1;
+    *pr = rows < (size_t)M ? (int)rows : M;
+    return 0;
+}
+
+//------------------------------
+// Spilling
+//------------------------------
+
+// Copy a text matrix into an unlinked temporary binary file so its columns can be
+// read in panels; returns a reader on the copy, or NULL on error (already reported)
+static MatrixReader *spill_to_binary(MatrixReader *text, size_t budget) {
+
+    const char *dir = getenv("TMPDIR");
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/matmul-spill-XXXXXX", dir && *dir ? dir : "/tmp");
+    int fd = mkstemp(path);
+    if (fd < 0) 
+    {
+        perror(path);
+        return NULL;
+    }
+    close(fd);
+
+    const int rows = matrix_reader_rows(text), cols = matrix_reader_cols(text);
+    MatrixWriter *w = open_matrix_writer(path, rows, cols, 1);
+    if (!w) 
+    {
+        unlink(path);
+        return NULL;
+    }
+
+    // Copy a budget-sized run of rows at a time
+    size_t chunk = budget / panel_bytes(1, cols);
+    if (chunk == 0) chunk = 1;
+    if (chunk > (size_t)rows) chunk = (size_t)rows;
+    Matrix *buf = create_matrix((int)chunk, cols);
+
+    int status = 0;
+    for (int r = 0; r < rows && status == 0; r += (int)chunk) 
+    {
+        int n = rows - r < (int)chunk ? rows - r : (int)chunk;
+        status = read_matrix_block(text, r, n, 0, cols, buf->data, buf->stride);
+        if (status == 0) status = write_matrix_rows(w, buf->data, buf->stride, n);
+    }
+    free_matrix(buf);
+    if (close_matrix_writer(w) != 0) status = -1;
+
+    MatrixReader *bin = status == 0 ? open_matrix_reader(path) : NULL;
+    unlink(path); // The open reader keeps the data until it is closed
+    return bin;
+}
+
+//------------------------------
+// Driver
+//------------------------------
+
+int stream_multiply(const char *a_filename, const char *b_filename, const char *out_filename,
+                    int binary_out, size_t budget, ThreadPool *pool) {
+
+    MatrixReader *ra = open_matrix_reader(a_filename);
+    MatrixReader *rb = ra ? open_matrix_reader(b_filename) : NULL;
+    if (!ra || !rb) 
+    {
+        close_matrix_reader(ra);
+        return -1;
+    }
+
+    const int M = matrix_reader_rows(ra);
+    const int K = matrix_reader_cols(ra);
+    const int N = matrix_reader_cols(rb);
+    int pr, pc;
+    if (K != matrix_reader_rows(rb)) 
+    {
+        fprintf(stderr, "Error: Incompatible matrix dimensions for multiplication.\n");
+        close_matrix_reader(ra);
+        close_matrix_reader(rb);
+        return -1;
+    }
+    if (plan_panels(M, K, N, budget, &pr, &pc) != 0) 
+    {
+        fprintf(stderr, "Error: memory budget of %zu bytes is too small for a %dx%d by %dx%d product.\n",
+                budget, M, K, K, N);
+        close_matrix_reader(ra);
+        close_matrix_reader(rb);
+        return -1;
+    }
+    const int a_panels = (M + pr - 1) / pr;
+    const int b_panels = (N + pc - 1) / pc;
+
+    // Column panels need random access to B
+    if (b_panels > 1 && !matrix_reader_is_binary(rb)) 
+    {
+        MatrixReader *spilled = spill_to_binary(rb, budget / 2);
+        close_matrix_reader(rb);
+        rb = spilled;
+        if (!rb) 
+        {
+            close_matrix_reader(ra);
+            return -1;
+        }
+    }
+
+    MatrixWriter *wc = open_matrix_writer(out_filename, M, N, binary_out);
+    if (!wc) 
+    {
+        close_matrix_reader(ra);
+        close_matrix_reader(rb);
+        return -1;
+    }
+
+    // Double buffers: panel p of A and C, and the t-th B panel loaded, use slot p % 2 / t % 2
+    Matrix *a_buf[2] = { create_matrix(pr, K), a_panels > 1 ? create_matrix(pr, K) : NULL };
+    Matrix *c_buf[2] = { create_matrix(pr, N), a_panels > 1 ? create_matrix(pr, N) : NULL };
+    Matrix *b_buf[2] = { create_matrix(K, pc), b_panels > 1 ? create_matrix(K, pc) : NULL };
+    PanelIO a_io = { 0 }, b_io = { 0 }, c_io = { 0 };
+    int status = 0;
+
+    // Prime the pipeline: first A panel, and either all of B or its first panel
+    start_read(&a_io, ra, a_buf[0], 0, pr < M ? pr : M, 0, K);
+    start_read(&b_io, rb, b_buf[0], 0, K, 0, pc);
+    if (b_panels == 1) 
+    {
+        status |= finish_io(&b_io); // B stays resident for every A panel
+    }
+
+    size_t t = 0; // B panels consumed so far
+    for (int p = 0; p < a_panels && status == 0; p++) 
+    {
+        const int row0 = p * pr;
+        const int nrows = M - row0 < pr ? M - row0 : pr;
+        Matrix *A = a_buf[p % 2];
+        Matrix *C = c_buf[p % 2];
+
+        // This A panel must be in; start the next one behind it
+        status |= finish_io(&a_io);
+        if (status != 0) break;
+        if (p + 1 < a_panels) 
+        {
+            const int next0 = row0 + pr;
+            start_read(&a_io, ra, a_buf[(p + 1) % 2], next0, M - next0 < pr ? M - next0 : pr, 0, K);
+        }
+        A->rows = nrows;
+        C->rows = nrows;
+
+        for (int q = 0; q < b_panels && status == 0; q++, t++) 
+        {
+            const int col0 = q * pc;
+            Matrix *B = b_buf[b_panels > 1 ? t % 2 : 0];
+
+            if (b_panels > 1) // Wait for this B panel and prefetch the one after it
+            {
+                status |= finish_io(&b_io);
+                if (status != 0) break;
+                B->cols = N - col0 < pc ? N - col0 : pc;
+                const int next_q = (q + 1) % b_panels;
+                if (q + 1 < b_panels || p + 1 < a_panels) 
+                {
+                    const int next_cols = N - next_q * pc < pc ? N - next_q * pc : pc;
+                    start_read(&b_io, rb, b_buf[(t + 1) % 2], 0, K, next_q * pc, next_cols);
+                }
+            }
+
+            PanelArgs args = { A, B, C, col0 };
+            pool_submit_range(pool, multiply_panel_rows, &args, 0, (size_t)nrows, 1);
+            pool_wait(pool);
+        }
+
+        // One write in flight at a time: the previous panel's must finish before this one starts
+        status |= finish_io(&c_io);
+        if (status == 0) start_write(&c_io, wc, C, nrows);
+    }
+
+    // Drain whatever is still in flight
+    status |= finish_io(&a_io);
+    status |= finish_io(&b_io);
+    status |= finish_io(&c_io);
+    if (close_matrix_writer(wc) != 0) status = -1;
+
+    for (int i = 0; i < 2; i++) 
+    {
+        free_matrix(a_buf[i]);
+        free_matrix(b_buf[i]);
+        free_matrix(c_buf[i]);
+    }
+    close_matrix_reader(ra);
+    close_matrix_reader(rb);
+    return status == 0 ? 0 : -1;
+}
@@ -0,0 +1,20 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <stddef.h>
+#include "pool.h"
+
+// Default memory budget of the streaming mode, in bytes
+#define DEFAULT_STREAM_BUDGET ((size_t)256 << 20)
+
+// Out-of-core product: C = A x B without ever holding A, B or C whole.
+// A is read in row panels and B in column panels (text or binary files; a text B
+// that does not fit in one panel is first spilled to a temporary binary file);
+// each finished row panel of C is appended to out_filename (binary if binary_out)
+// while the next one is computed. Panel buffers, double-buffered so that reads and
+// writes overlap the compute on the pool, stay within budget bytes.
+// Returns 0 on success, -1 on error (already reported).
+int stream_multiply(const char *a_filename, const char *b_filename, const char *out_filename,
+                    int binary_out, size_t budget, ThreadPool *pool);
+
+#endif
@@ -1,266 +1,485 @@
 #include <stdio.h>   // Standard I/O functions
 #include <stdlib.h>  // Memory management
 #include <string.h>  // String management
-#include <pthread.h> // Thread management
-
-
-// Maximum matrix dimensions (not larger than 20x20)
-#define MAX_DIM 20
+#include <getopt.h>  // Command-line option parsing
+#include <unistd.h>  // access()
+#include <pthread.h> // B is loaded on its own thread while A is read
+#include "matrix.h"   // Matrix storage and file I/O
+#include "pool.h"     // Persistent worker thread pool
+#include "multiply.h" // Multiplication tasks for the four methods
+#include "kernels.h"  // SIMD inner loops with runtime CPU dispatch
+#include "stream.h"   // Out-of-core product in panels
+#include "strassen.h" // Recursive Strassen method
+#include "sparse.h"   // CSR inputs and sparse products
+#include "placement.h" // Worker pinning and NUMA first touch
+#include "tune.h"      // Auto-tuned method selection
+#include "batch.h"     // Many products through one pool
+#include "chain.h"     // Chained products and powers in memory
 
 //------------------------------
-// Matrix Structure and Functions
+// Main Program
 //------------------------------
-typedef struct {
-    int rows;          // Number of rows
-    int cols;          // Number of columns
-    int **data;        // 2D array to store matrix elements
-} Matrix;
 
-// Allocate a new matrix with given dimensions; memory is zero‐initialized
-Matrix *create_matrix(int rows, int cols) {
+// Input name -> file: used as is when it already names a .txt, .bin or .coo file,
+// otherwise NAME.txt, falling back to NAME.bin when only that exists.
+static void input_filename(char *out, size_t size, const char *name) {
 
-    Matrix *mat = malloc(sizeof(Matrix)); //Dynamically allocates memory for the Matrix struct
-    if (!mat) 
+    const char *ext = strrchr(name, '.');
+    if (ext && (strcmp(ext, ".txt") == 0 || strcmp(ext, ".bin") == 0 || strcmp(ext, ".coo") == 0)) 
     {
-        perror("malloc");
-        exit(EXIT_FAILURE);
+        snprintf(out, size, "%s", name);
+        return;
     }
-
-    //Set the matrix dimensions using the input arguments
-    mat->rows = rows;
-    mat->cols = cols;
-    mat->data = malloc(rows * sizeof(int *)); //Create an array of pointers, where each pointer will later point to a row of integers
-    if (!mat->data) 
+    snprintf(out, size, "%s.txt", name);
+    if (access(out, F_OK) != 0) 
     {
-        perror("malloc");
-        exit(EXIT_FAILURE);
+        snprintf(out, size, "%s.bin", name);
+        if (access(out, F_OK) != 0) snprintf(out, size, "%s.txt", name); // Report the usual name
     }
+}
 
-    for (int i = 0; i < rows; i++) {
-        mat->data[i] = calloc(cols, sizeof(int)); //allocate memory for a row of cols integers and initializes them to 0
-        if (!mat->data[i]) 
-        {
-            perror("calloc");
-            exit(EXIT_FAILURE);
-        }
-    }
-    return mat;
+// PREFIX_per_METHOD.txt (or .bin)
+static void result_filename(char *out, size_t size, const char *prefix, const char *method, int binary) {
+
+    snprintf(out, size, "%s_per_%s.%s", prefix, method, binary ? "bin" : "txt");
 }
 
-// Free a matrix created by create_matrix()
-void free_matrix(Matrix *mat) {
+// Writes one result in the selected output format; 0 on success, -1 on error
+static int write_result(const char *prefix, const char *method, Matrix *mat, ThreadPool *pool, int binary) {
 
-    if (mat)  // Check if matrix exists
+    char filename[256];
+    result_filename(filename, sizeof(filename), prefix, method, binary);
+    if (binary) 
     {
-        // Free each row's data array
-        for (int i = 0; i < mat->rows; i++) 
-        {
-            free(mat->data[i]);  // Release memory for individual rows
-        }
-        free(mat->data);    // Free the array of row pointers
-        free(mat);          // Free the matrix structure itself
+        return write_matrix_binary(filename, mat);
     }
+    return write_matrix_to_file(filename, mat, pool);
 }
 
-// Reads a matrix from a text file
-Matrix *read_matrix_from_file(const char *filename) {
+// Zeroed result matrix; with --numa each worker zeroes the rows it owns
+static Matrix *create_result(ThreadPool *pool, int rows, int cols, MatrixType type, int numa) {
 
-    // open the input file
-    FILE *fp = fopen(filename, "r");
-    if (!fp) 
-    {
-        perror(filename);  // Print system error message
-        return NULL;
-    }
+    return numa ? create_matrix_placed(pool, rows, cols, type) : create_matrix_typed(rows, cols, type);
+}
+
+// "512M", "2G", "65536K" or plain bytes; returns 0 on success
+static int parse_size(const char *text, size_t *out) {
 
-    // Read the file
-    char buffer[256];
-    if (!fgets(buffer, sizeof(buffer), fp)) 
+    char *end;
+    unsigned long long value = strtoull(text, &end, 10);
+    int shift = 0;
+    switch (*end) 
     {
-        fclose(fp);  // Close file before returning
-        return NULL; // File empty or read error
+        case 'k': case 'K': shift = 10; end++; break;
+        case 'm': case 'M': shift = 20; end++; break;
+        case 'g': case 'G': shift = 30; end++; break;
     }
-
-    // Parse dimensions from header line
-    int rows, cols;
-    if (sscanf(buffer, "row=%d col=%d", &rows, &cols) != 2)
+    if (end == text || *end != '\0' || value == 0) 
     {
-        fprintf(stderr, "Error: invalid header format in %s\n", filename);
-        fclose(fp);
-        return NULL;
+        return -1;
     }
+    *out = (size_t)(value << shift);
+    return 0;
+}
 
-    // Validate matrix dimensions against MAX_DIM constraint
-    if (rows > MAX_DIM || cols > MAX_DIM) 
+// B and its packed copy, loaded on a helper thread while the main thread reads A.
+// Both files are parsed on the shared pool, each waiting only for its own chunks.
+typedef struct {
+    const char *filename;
+    MatrixType type;
+    ThreadPool *pool;
+    Matrix *B;
+    Matrix *Bt;   // Packed as soon as B is in (int32 only), while A may still be parsing
+} OperandLoad;
+
+static void *load_operand_main(void *arg) {
+
+    OperandLoad *load = (OperandLoad *)arg;
+    load->B = read_matrix_as(load->filename, load->type, load->pool);
+    if (load->B && load->type == MATRIX_INT32) load->Bt = pack_transposed(load->pool, load->B);
+    return NULL;
+}
+
+// --verify: 0 when both results hold the same elements, otherwise 1 after reporting
+// the first difference. Every method computes bit-identical results, floats included.
+static int compare_results(const Matrix *X, const char *x_method, const Matrix *Y, const char *y_method) {
+
+    const size_t elem_size = matrix_type_size(X->type);
+    const size_t row_bytes = (size_t)X->cols * elem_size;
+    for (int i = 0; i < X->rows; i++) 
     {
-        fprintf(stderr, "Error: matrix dimensions exceed maximum allowed (%d)\n", MAX_DIM);
-        fclose(fp);
-        return NULL;
+        const char *x = (const char *)X->data + (size_t)i * X->stride * elem_size;
+        const char *y = (const char *)Y->data + (size_t)i * Y->stride * elem_size;
+        if (memcmp(x, y, row_bytes) == 0) continue;
+
+        int j = 0;
+        while (memcmp(x + (size_t)j * elem_size, y + (size_t)j * elem_size, elem_size) == 0) j++;
+        fprintf(stderr, "Error: per_%s and per_%s differ at (%d, %d).\n", x_method, y_method, i, j);
+        return 1;
     }
+    return 0;
+}
 
-    // Allocate matrix structure
-    Matrix *mat = create_matrix(rows, cols);
-
-    // Read matrix elements row by row
-    for (int i = 0; i < rows; i++) 
+// --once: C = A x B computed once with the tiled method, written under the first
+// method's name and copied (reflinked where possible) to the others. With verify,
+// the other methods run as well, one at a time into a scratch matrix, and must agree.
+static int run_once(const char *prefix, Matrix *A, Matrix *B, Matrix *Bt, int tile_l2, int tile_l1,
+                    int strassen, int strassen_cutoff, int verify, int binary, ThreadPool *pool) {
+
+    const MatrixType type = A->type;
+    Matrix *C = create_matrix_typed(A->rows, B->cols, type);
+    TileMultArgs args = { A, B, C, tile_l2, tile_l1 };
+    submit_per_tile(pool, &args);
+    pool_wait(pool);
+
+    const char *methods[5] = { "matrix", "row", "element", "tile", "strassen" };
+    const int count = strassen ? 5 : 4;
+    int failed = 0;
+    if (verify) 
     {
-        for (int j = 0; j < cols; j++) 
+        Matrix *check = create_matrix_typed(A->rows, B->cols, type);
+        MatMultArgs margs = { A, B, check, Bt };
+        void (*submit[3])(ThreadPool *, MatMultArgs *) = { submit_per_matrix, submit_per_row, submit_per_element };
+        for (int m = 0; m < count; m++) 
         {
-            // Read single integer element
-            if (fscanf(fp, "%d", &(mat->data[i][j])) != 1) 
+            if (m == 3) continue; // The tiled result itself
+            memset(check->data, 0, matrix_bytes(check->rows, check->cols, type));
+            if (m < 3) 
+            {
+                submit[m](pool, &margs);
+                pool_wait(pool);
+            }
+            else 
             {
-                fprintf(stderr, "Error reading matrix element (%d, %d) from %s\n", i, j, filename);
-                free_matrix(mat);  // Cleanup partially read matrix
-                fclose(fp);
-                return NULL;
+                StrassenArgs sargs = { A, B, check, strassen_cutoff, tile_l2, tile_l1 };
+                multiply_strassen(pool, &sargs);
             }
+            failed |= compare_results(check, methods[m], C, "tile");
         }
+        free_matrix(check);
+        if (!failed) printf("verify: every method agrees with per_tile\n");
     }
 
-    fclose(fp);  // Close file after successful read
-    return mat;  // Return fully initialized matrix
+    char first[256];
+    result_filename(first, sizeof(first), prefix, methods[0], binary);
+    const int written = write_result(prefix, methods[0], C, pool, binary) == 0;
+    failed |= !written;
+    for (int m = 1; m < count && written; m++) 
+    {
+        char filename[256];
+        result_filename(filename, sizeof(filename), prefix, methods[m], binary);
+        failed |= copy_matrix_file(first, filename) != 0;
+    }
+    free_matrix(C);
+    return failed ? EXIT_FAILURE : 0;
 }
 
-// Writes a matrix to a text file in the specified format
-void write_matrix_to_file(const char *filename, Matrix *mat) {
+// --sparse: C = A x B with whichever operands are sparse kept in CSR. Two dense
+// operands fall back to the tiled method.
+static int run_sparse(const char *inA, const char *inB, const char *prefix, ThreadPool *pool, int binary) {
 
-    // open the output file in write mode
-    FILE *fp = fopen(filename, "w");
-    if (!fp)
+    SparseMatrix *As, *Bs;
+    Matrix *Ad, *Bd;
+    if (load_sparse_operand(inA, pool, &As, &Ad) != 0 || load_sparse_operand(inB, pool, &Bs, &Bd) != 0) 
     {
-        perror(filename);  // Display system error message
-        return;            // Abort operation if file can't be opened
+        fprintf(stderr, "Error reading input matrices.\n");
+        exit(EXIT_FAILURE);
     }
-
-    // Write matrix dimensions header line
-    fprintf(fp, "row=%d col=%d\n", mat->rows, mat->cols);
-
-    // Write matrix elements row by row
-    for (int i = 0; i < mat->rows; i++) 
+    const int rows = As ? As->rows : Ad->rows;
+    const int inner = As ? As->cols : Ad->cols;
+    const int cols = Bs ? Bs->cols : Bd->cols;
+    if (inner != (Bs ? Bs->rows : Bd->rows)) 
     {
-        // Write all columns in current row
-        for (int j = 0; j < mat->cols; j++) 
-        {
-            fprintf(fp, "%d ", mat->data[i][j]);  // Space-separated values
-        }
-        fprintf(fp, "\n");  // Newline after each row
+        fprintf(stderr, "Error: Incompatible matrix dimensions for multiplication.\n");
+        exit(EXIT_FAILURE);
     }
 
-    fclose(fp); // Close the file stream
+    Matrix *C = create_matrix(rows, cols);
+    if (As || Bs) 
+    {
+        SpmmArgs args = { As, Ad, Bs, Bd, C };
+        multiply_sparse(pool, &args);
+    }
+    else 
+    {
+        TileMultArgs args = { Ad, Bd, C, DEFAULT_TILE_L2, DEFAULT_TILE_L1 };
+        submit_per_tile(pool, &args);
+        pool_wait(pool);
+    }
+    const int status = write_result(prefix, "sparse", C, pool, binary);
+
+    free_sparse_matrix(As);
+    free_sparse_matrix(Bs);
+    free_matrix(Ad);
+    free_matrix(Bd);
+    free_matrix(C);
+    return status == 0 ? 0 : EXIT_FAILURE;
 }
 
-//------------------------------
-// Structures for Thread Arguments
-//------------------------------
-
-// For method 1 (thread per matrix)
-typedef struct {
-    Matrix *A;
-    Matrix *B;
-    Matrix *C;
-} MatMultArgs;
-
-// For method 2 (thread per row)
-typedef struct {
-    Matrix *A;
-    Matrix *B;
-    Matrix *C;
-    int row; // row index to compute
-} RowMultArgs;
+// --auto: one product with the method, kernels and pool size cached for this shape,
+// type and host, probing them first on a cache miss. Runs before any pool exists,
+// so a warm cache costs one small file read.
+static int run_auto(const char *inA, const char *inB, const char *prefix, MatrixType type, int binary,
+                    const char *tuning_file, int pin) {
 
-// For method 3 (thread per element)
-typedef struct {
-    Matrix *A;
-    Matrix *B;
-    Matrix *C;
-    int row; // row index
-    int col; // column index
-} ElementMultArgs;
-
-//------------------------------
-// Thread Worker Functions
-//------------------------------
-
-// Method 1: One thread computes the entire matrix multiplication.
-void *multiply_matrix(void *arg) {
+    int rows, inner, inner_b, cols;
+    if (read_matrix_shape(inA, &rows, &inner) != 0 || read_matrix_shape(inB, &inner_b, &cols) != 0) 
+    {
+        fprintf(stderr, "Error reading input matrices.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (inner != inner_b) 
+    {
+        fprintf(stderr, "Error: Incompatible matrix dimensions for multiplication.\n");
+        exit(EXIT_FAILURE);
+    }
 
-    MatMultArgs *args = (MatMultArgs *)arg;
-    Matrix *A = args->A;
-    Matrix *B = args->B;
-    Matrix *C = args->C;
+    TuneConfig config;
+    const int cached = tune_lookup(tuning_file, rows, inner, cols, type, &config) == 0;
+    if (!cached) 
+    {
+        tune_probe(rows, inner, cols, type, &config);
+        tune_store(tuning_file, rows, inner, cols, type, &config); // A failed write only costs the next run a probe
+    }
+    printf("auto: per_%s, %s kernels, %zu threads (%s)\n", tune_method_name(config.method), config.kernel,
+           config.threads, cached ? "cached" : "tuned");
 
-    
-    for (int i = 0; i < A->rows; i++) // Iterate over all rows of matrix A
+    ThreadPool *pool = create_pool(config.threads);
+    Placement *place = pin ? pin_workers(pool) : NULL;
+    Matrix *A = read_matrix_as(inA, type, pool);
+    Matrix *B = read_matrix_as(inB, type, pool);
+    if (!A || !B) 
     {
-        
-        for (int j = 0; j < B->cols; j++) // Iterate over all columns of matrix B
-        {
-            int sum = 0;
-            for (int k = 0; k < A->cols; k++) 
-            {
-                sum += A->data[i][k] * B->data[k][j]; // Compute the product of A's row and B's column
-            }
-            C->data[i][j] = sum;  // Store computed value
-        }
+        fprintf(stderr, "Error reading input matrices.\n");
+        exit(EXIT_FAILURE);
     }
-    free(args);  // Release argument memory
-    return NULL;
-}
+    Matrix *C = create_matrix_typed(rows, cols, type);
+    tune_multiply(pool, &config, A, B, C);
+    const int status = write_result(prefix, "auto", C, pool, binary);
 
-// Method 2: thread per row.
-void *multiply_row(void *arg) {
+    free_pool(pool);
+    free_placement(place);
+    free_matrix(A);
+    free_matrix(B);
+    free_matrix(C);
+    return status == 0 ? 0 : EXIT_FAILURE;
+}
 
-    RowMultArgs *args = (RowMultArgs *)arg;
-    Matrix *A = args->A;
-    Matrix *B = args->B;
-    Matrix *C = args->C;
-    const int i = args->row;  // Target row index
+// --chain / --power: names[0..count) are the inputs followed by the output prefix. Every
+// input is read once; intermediates never leave memory.
+static int run_chain(char **names, int count, int chain, unsigned long long power, MatrixType type, int binary,
+                     int tile_l2, int tile_l1, ThreadPool *pool) {
 
-    // Compute all columns in assigned row
-    for (int j = 0; j < B->cols; j++) // Iterate all columns in assigned row
+    const int n = count - 1;
+    if (chain ? n < 2 : n != 1) 
     {
-        int sum = 0;
-        for (int k = 0; k < A->cols; k++) 
+        fprintf(stderr, chain ? "Error: --chain needs at least two input matrices and an output prefix.\n"
+                              : "Error: --power needs one input matrix and an output prefix.\n");
+        return EXIT_FAILURE;
+    }
+    Matrix **M = calloc((size_t)n, sizeof(Matrix *));
+    if (!M) 
+    {
+        perror("calloc");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < n; i++) 
+    {
+        char filename[256];
+        input_filename(filename, sizeof(filename), names[i]);
+        M[i] = read_matrix_as(filename, type, pool);
+        if (!M[i]) 
         {
-            sum += A->data[i][k] * B->data[k][j]; // Dot product for single element
+            fprintf(stderr, "Error reading input matrices.\n");
+            exit(EXIT_FAILURE);
         }
-        C->data[i][j] = sum;
     }
-    free(args);  // Release argument memory
-    return NULL;
-}
-
-// Method 3: One thread per element.
-void *multiply_element(void *arg) {
 
-    ElementMultArgs *args = (ElementMultArgs *)arg;
-    Matrix *A = args->A;
-    Matrix *B = args->B;
-    Matrix *C = args->C;
-    const int i = args->row;  // Target row
-    const int j = args->col;  // Target column
-
-    int sum = 0;
-    
-    for (int k = 0; k < A->cols; k++) 
+    ChainReport report;
+    int status = EXIT_FAILURE;
+    Matrix *C = chain ? multiply_chain(pool, M, n, tile_l2, tile_l1, &report)
+                      : matrix_power(pool, M[0], power, tile_l2, tile_l1, &report);
+    if (C) 
     {
-        sum += A->data[i][k] * B->data[k][j]; // Compute dot product for single element
+        printf("%s: %s, %d products, %.0f multiply-adds, %d buffers\n", chain ? "chain" : "power", report.order,
+               report.products, report.multiply_adds, report.buffers);
+        status = write_result(names[n], chain ? "chain" : "power", C, pool, binary) == 0 ? 0 : EXIT_FAILURE;
     }
 
-    C->data[i][j] = sum;  // Store result
-    free(args);           // Compute dot product for single element
-    return NULL;
+    for (int i = 0; i < n; i++) free_matrix(M[i]);
+    free(M);
+    free_matrix(C);
+    return status;
+}
+
+static void usage(const char *prog) {
+
+    fprintf(stderr, "Usage: %s [options] [Mat1 Mat2 MatOut]\n"
+                    "       %s --chain [options] Mat1 Mat2 ... MatN MatOut\n"
+                    "       %s --power=K [options] Mat MatOut\n"
+                    "  --tile-l1=N   edge of the L1 sub-blocks used by the tiled method (default %d)\n"
+                    "  --tile-l2=N   edge of the output tiles used by the tiled method (default %d)\n"
+                    "  --kernel=NAME force the inner-loop kernels: avx512, avx2 or scalar (default: best for this CPU)\n"
+                    "  --type=TYPE   element type: int32, int64, float or double (default int32); int64 and\n"
+                    "                float accumulate in 64 bits (int64 wraps modulo 2^64, float sums in double)\n"
+                    "  --output-format=text|binary  format of the result files (default text)\n"
+                    "  --strassen    also run method 5 (Strassen recursion) into MatOut_per_strassen\n"
+                    "  --strassen-cutoff=N  recurse while every dimension exceeds N (default %d)\n"
+                    "  --sparse      multiply on the sparse path only, writing MatOut_per_sparse (inputs in the\n"
+                    "                sparse format, or at most 25%% nonzero, are used as CSR)\n"
+                    "  --stream      multiply out of core in panels, writing only MatOut_per_panel\n"
+                    "  --mem-budget=SIZE  panel memory for --stream, e.g. 512M or 4G (default %zuM)\n"
+                    "  --pin         pin each worker thread to its own CPU, filling one NUMA node at a time\n"
+                    "  --numa        --pin, and give each worker fixed rows of C that it first touches,\n"
+                    "                with a copy of B on every NUMA node\n"
+                    "  --auto        run only the method, kernels and thread count found fastest for this\n"
+                    "                shape, type and host, writing MatOut_per_auto (probed once, then cached)\n"
+                    "  --tuning-file=PATH  cache used by --auto (default %s)\n"
+                    "  --batch=MANIFEST  multiply every \"A B out\" line of MANIFEST (file names as given, out\n"
+                    "                written whole), on one pool with the tiled method; --batch=- reads pairs\n"
+                    "                of text matrices from stdin and writes their products to stdout\n"
+                    "  --chain       multiply Mat1 x ... x MatN in the cheapest order into MatOut_per_chain\n"
+                    "  --power=K     raise the square Mat to the power K (repeated squaring) into MatOut_per_power\n"
+                    "  --once        compute the product once (tiled method), write it once and copy it to\n"
+                    "                every other MatOut_per_* name (a reflink where the filesystem allows)\n"
+                    "  --verify      cross-check the methods against each other and fail on any difference\n"
+                    "Inputs may be text or binary matrix files; see matconv.\n",
+            prog, prog, prog, DEFAULT_TILE_L1, DEFAULT_TILE_L2, DEFAULT_STRASSEN_CUTOFF, DEFAULT_STREAM_BUDGET >> 20,
+            DEFAULT_TUNING_FILE);
 }
 
-//------------------------------
-// Main Program
-//------------------------------
 int main(int argc, char *argv[]) //arguments count and array  stores it 
 {
-    // Determine input/output file names based on command-line arguments.
+    // Parse options (they come before the file names)
+    int tile_l1 = DEFAULT_TILE_L1, tile_l2 = DEFAULT_TILE_L2;
+    int binary_output = 0;
+    int streaming = 0;
+    int sparse = 0;
+    int strassen = 0, strassen_cutoff = DEFAULT_STRASSEN_CUTOFF;
+    size_t budget = DEFAULT_STREAM_BUDGET;
+    MatrixType type = MATRIX_INT32;
+    int pin = 0, numa = 0;
+    int auto_mode = 0, forced_kernel = 0;
+    const char *tuning_file = DEFAULT_TUNING_FILE;
+    const char *batch = NULL;
+    int chain = 0, power_mode = 0;
+    unsigned long long power = 0;
+    int once = 0, verify = 0;
+    static const struct option long_options[] = {
+        { "tile-l1", required_argument, NULL, '1' },
+        { "tile-l2", required_argument, NULL, '2' },
+        { "kernel",  required_argument, NULL, 'k' },
+        { "type",    required_argument, NULL, 't' },
+        { "output-format", required_argument, NULL, 'f' },
+        { "strassen", no_argument,      NULL, 'S' },
+        { "strassen-cutoff", required_argument, NULL, 'c' },
+        { "sparse",  no_argument,       NULL, 'p' },
+        { "stream",  no_argument,       NULL, 's' },
+        { "mem-budget", required_argument, NULL, 'm' },
+        { "pin",     no_argument,       NULL, 'P' },
+        { "numa",    no_argument,       NULL, 'n' },
+        { "auto",    no_argument,       NULL, 'a' },
+        { "tuning-file", required_argument, NULL, 'T' },
+        { "batch",   required_argument, NULL, 'b' },
+        { "chain",   no_argument,       NULL, 'C' },
+        { "power",   required_argument, NULL, 'w' },
+        { "once",    no_argument,       NULL, 'o' },
+        { "verify",  no_argument,       NULL, 'v' },
+        { "help",    no_argument,       NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "h", long_options, NULL)) != -1) 
+    {
+        switch (opt) 
+        {
+            case '1': tile_l1 = atoi(optarg); break;
+            case '2': tile_l2 = atoi(optarg); break;
+            case 'k': if (select_kernels(optarg) != 0) return EXIT_FAILURE; forced_kernel = 1; break;
+            case 't': if (parse_matrix_type(optarg, &type) != 0) return EXIT_FAILURE; break;
+            case 'f':
+                if (strcmp(optarg, "text") == 0) binary_output = 0;
+                else if (strcmp(optarg, "binary") == 0) binary_output = 1;
+                else { fprintf(stderr, "Error: unknown output format '%s'.\n", optarg); return EXIT_FAILURE; }
+                break;
+            case 'S': strassen = 1; break;
+            case 'c': strassen_cutoff = atoi(optarg); break;
+            case 'p': sparse = 1; break;
+            case 's': streaming = 1; break;
+            case 'm':
+                if (parse_size(optarg, &budget) != 0) { fprintf(stderr, "Error: invalid memory budget '%s'.\n", optarg); return EXIT_FAILURE; }
+                break;
+            case 'P': pin = 1; break;
+            case 'n': numa = pin = 1; break;
+            case 'a': auto_mode = 1; break;
+            case 'T': tuning_file = optarg; break;
+            case 'b': batch = optarg; break;
+            case 'C': chain = 1; break;
+            case 'o': once = 1; break;
+            case 'v': verify = 1; break;
+            case 'w':
+                {
+                    char *end;
+                    power = strtoull(optarg, &end, 10);
+                    if (end == optarg || *end != '\0' || optarg[0] == '-') 
+                    {
+                        fprintf(stderr, "Error: invalid power '%s'.\n", optarg);
+                        return EXIT_FAILURE;
+                    }
+                    power_mode = 1;
+                }
+                break;
+            case 'h': usage(argv[0]); return 0;
+            default:  usage(argv[0]); return EXIT_FAILURE;
+        }
+    }
+    if (tile_l1 <= 0 || tile_l2 <= 0) 
+    {
+        fprintf(stderr, "Error: tile sizes must be positive.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (strassen_cutoff < MIN_STRASSEN_CUTOFF) 
+    {
+        fprintf(stderr, "Error: the Strassen cutoff must be at least %d.\n", MIN_STRASSEN_CUTOFF);
+        exit(EXIT_FAILURE);
+    }
+    if (type != MATRIX_INT32 && (streaming || sparse || strassen)) 
+    {
+        fprintf(stderr, "Error: --stream, --sparse and --strassen only support int32 elements.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (auto_mode && (streaming || sparse || strassen || numa || forced_kernel)) 
+    {
+        fprintf(stderr, "Error: --auto picks the method and kernels itself; it cannot be combined with\n"
+                        "--stream, --sparse, --strassen, --numa or --kernel.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (batch && (streaming || sparse || strassen || numa || auto_mode)) 
+    {
+        fprintf(stderr, "Error: --batch cannot be combined with --stream, --sparse, --strassen, --numa or --auto.\n");
+        exit(EXIT_FAILURE);
+    }
+    if ((chain || power_mode) && (chain + power_mode > 1 || streaming || sparse || strassen || numa || auto_mode || batch)) 
+    {
+        fprintf(stderr, "Error: --chain and --power cannot be combined with each other or with --stream, --sparse,\n"
+                        "--strassen, --numa, --auto or --batch.\n");
+        exit(EXIT_FAILURE);
+    }
+    if ((once || verify) && (streaming || sparse || auto_mode || batch || chain || power_mode)) 
+    {
+        fprintf(stderr, "Error: --once and --verify apply to the four methods; they cannot be combined with\n"
+                        "--stream, --sparse, --auto, --batch, --chain or --power.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (once && numa) 
+    {
+        fprintf(stderr, "Error: --once cannot be combined with --numa.\n");
+        exit(EXIT_FAILURE);
+    }
 
+    // Determine input/output file names based on the remaining arguments.
     char inA_filename[256], inB_filename[256], out_prefix[256];
-    if (argc < 4)   // Default: input files "a.txt" and "b.txt", output prefix "c"
+    if (argc - optind < 3)   // Default: input files "a.txt" and "b.txt", output prefix "c"
      { 
         strcpy(inA_filename, "a.txt");
         strcpy(inB_filename, "b.txt");
@@ -268,15 +487,74 @@ int main(int argc, char *argv[]) //arguments count and array  stores it
     } 
     else 
     {   // construct filenames from user input.
-        snprintf(inA_filename, sizeof(inA_filename), "%s.txt", argv[1]);
-        snprintf(inB_filename, sizeof(inB_filename), "%s.txt", argv[2]);
-        strncpy(out_prefix, argv[3], sizeof(out_prefix) - 1);
+        input_filename(inA_filename, sizeof(inA_filename), argv[optind]);
+        input_filename(inB_filename, sizeof(inB_filename), argv[optind + 1]);
+        strncpy(out_prefix, argv[optind + 2], sizeof(out_prefix) - 1);
         out_prefix[sizeof(out_prefix) - 1] = '\0';
     }
 
-    // Read matrices A and B from their corresponding files.
-    Matrix *A = read_matrix_from_file(inA_filename);
-    Matrix *B = read_matrix_from_file(inB_filename);
+    if (auto_mode) 
+    {
+        return run_auto(inA_filename, inB_filename, out_prefix, type, binary_output, tuning_file, pin);
+    }
+
+    // Worker threads are created once, sized to the online CPUs, and shared by parsing and all methods
+    ThreadPool *pool = create_pool(0);
+    Placement *place = pin ? pin_workers(pool) : NULL;
+    if (numa) pool_set_spread(pool, 1); // Worker w gets the same rows of every range
+
+    // Batch: the products named by the manifest (or stdin), one after another on this pool
+    if (batch) 
+    {
+        int status = run_batch(batch, type, binary_output, tile_l2, tile_l1, pool);
+        free_pool(pool);
+        free_placement(place);
+        return status == 0 ? 0 : EXIT_FAILURE;
+    }
+
+    // Chain or power: any number of inputs, one result
+    if (chain || power_mode) 
+    {
+        int status = run_chain(argv + optind, argc - optind, chain, power, type, binary_output, tile_l2, tile_l1, pool);
+        free_pool(pool);
+        free_placement(place);
+        return status;
+    }
+
+    // Streaming: A, B and C are never held whole; one result file
+    if (streaming) 
+    {
+        char filename[256];
+        snprintf(filename, sizeof(filename), "%s_per_panel.%s", out_prefix, binary_output ? "bin" : "txt");
+        int status = stream_multiply(inA_filename, inB_filename, filename, binary_output, budget, pool);
+        free_pool(pool);
+        free_placement(place);
+        return status == 0 ? 0 : EXIT_FAILURE;
+    }
+
+    // Sparse path: CSR operands, work split by nonzeros, dense result
+    if (sparse) 
+    {
+        int status = run_sparse(inA_filename, inB_filename, out_prefix, pool, binary_output);
+        free_pool(pool);
+        free_placement(place);
+        return status;
+    }
+
+    // Read matrices A and B from their corresponding files, concurrently: B (then its
+    // packed copy) on a helper thread, A on this one.
+    OperandLoad load_b = { inB_filename, type, pool };
+    pthread_t loader;
+    if (pthread_create(&loader, NULL, load_operand_main, &load_b) != 0) 
+    {
+        perror("pthread_create");
+        exit(EXIT_FAILURE);
+    }
+    Matrix *A = read_matrix_as(inA_filename, type, pool);
+    pthread_join(loader, NULL);
+    Matrix *B = load_b.B;
+    Matrix *Bt = load_b.Bt; // Column-major B: every row and element task reads it with unit stride.
+                            // The wider types walk B's rows directly instead.
     if (!A || !B) 
     {
         fprintf(stderr, "Error reading input matrices.\n");
@@ -289,123 +567,107 @@ int main(int argc, char *argv[]) //arguments count and array  stores it
         fprintf(stderr, "Error: Incompatible matrix dimensions for multiplication.\n");
         free_matrix(A);
         free_matrix(B);
+        free_matrix(Bt);
         exit(EXIT_FAILURE);
     }
 
+    // Compute once: one product behind every output name
+    if (once) 
+    {
+        int status = run_once(out_prefix, A, B, Bt, tile_l2, tile_l1, strassen, strassen_cutoff, verify,
+                              binary_output, pool);
+        free_pool(pool);
+        free_placement(place);
+        free_matrix(A);
+        free_matrix(B);
+        free_matrix(Bt);
+        return status;
+    }
+
     int rows = A->rows;
     int cols = B->cols;
 
     // Allocate result matrices for each multiplication method.
-    Matrix *C_matrix  = create_matrix(rows, cols);  // For method 1
-    Matrix *C_row     = create_matrix(rows, cols);  // For method 2
-    Matrix *C_element = create_matrix(rows, cols);  // For method 3
+    Matrix *C_matrix  = create_result(pool, rows, cols, type, numa);  // For method 1
+    Matrix *C_row     = create_result(pool, rows, cols, type, numa);  // For method 2
+    Matrix *C_element = create_result(pool, rows, cols, type, numa);  // For method 3
+    Matrix *C_tile    = create_result(pool, rows, cols, type, numa);  // For method 4
 
-    // ------------------------------
-    // Method 1: One thread per entire matrix.
-    // ------------------------------
-    pthread_t thread_matrix;  //Creates a thread identifier
-    MatMultArgs *args_matrix = malloc(sizeof(MatMultArgs)); //Dynamically allocates memory for a MatMultArgs struct 
-    if (!args_matrix) {perror("malloc"); exit(EXIT_FAILURE);} 
-    
-    //Initialize thread arguments
-    args_matrix->A = A;
-    args_matrix->B = B;
-    args_matrix->C = C_matrix;
+    // --numa on a multi-node host: B and Bt are read-only, so every node gets its own copy
+    Matrix **B_nodes = numa ? replicate_per_node(pool, place, B) : NULL;
+    Matrix **Bt_nodes = numa && Bt ? replicate_per_node(pool, place, Bt) : NULL;
 
-    if (pthread_create(&thread_matrix, NULL, multiply_matrix, args_matrix) != 0) //spawns a new thread that executes multiply_matrix.
-    {
-        perror("pthread_create");
-        exit(EXIT_FAILURE);
-    }
+    // Operands for each method; they must outlive the tasks that read them.
+    // Each method counts its tasks in its own group, so its result can be written
+    // as soon as it is done.
+    TaskGroup done[4] = { { 0 } };
+    MatMultArgs args_matrix  = { A, B, C_matrix, Bt, B_nodes, Bt_nodes, &done[0] };
+    MatMultArgs args_row     = { A, B, C_row, Bt, B_nodes, Bt_nodes, &done[1] };
+    MatMultArgs args_element = { A, B, C_element, Bt, B_nodes, Bt_nodes, &done[2] };
+    TileMultArgs args_tile   = { A, B, C_tile, tile_l2, tile_l1, B_nodes, &done[3] };
 
-    // ------------------------------
-    // Method 2: One thread per row.
-    // ------------------------------
-    pthread_t threads_row[rows]; //Creates threads identifiers
-    for (int i = 0; i < rows; i++) 
-    {
-        RowMultArgs *args_row = malloc(sizeof(RowMultArgs)); //Dynamically allocates memory for a RowMultArgs struct
-        if (!args_row) {perror("malloc"); exit(EXIT_FAILURE);}   
-        
-        //Initialize thread arguments
-        args_row->A = A;
-        args_row->B = B;
-        args_row->C = C_row;
-        args_row->row = i;
-
-        if (pthread_create(&threads_row[i], NULL, multiply_row, args_row) != 0) //spawns a new thread that executes multiply_row.
-        {
-            perror("pthread_create");
-            exit(EXIT_FAILURE);
-        }
-    }
+    // Method 1: One task for the entire matrix.
+    submit_per_matrix(pool, &args_matrix);
 
-    // ------------------------------
-    // Method 3: One thread per element.
-    // ------------------------------
-    int total_elements = rows * cols; //The total elements in the result matrix
+    // Method 2: Rows, split down to single rows while workers are idle.
+    submit_per_row(pool, &args_row);
 
-    pthread_t threads_element[total_elements]; //Creates threads identifiers
+    // Method 3: Elements, split down to single elements while workers are idle.
+    submit_per_element(pool, &args_element);
 
-    int index = 0; //Index to track threads in the array
+    // Method 4: Cache-blocked output tiles.
+    submit_per_tile(pool, &args_tile);
 
-    for (int i = 0; i < rows; i++) 
+    // ------------------------------
+    // Write result matrices to output files, each as soon as its method finishes: the
+    // formatting and writes share the pool with the methods still computing.
+    // ------------------------------
+    const char *method_names[4] = { "matrix", "row", "element", "tile" };
+    Matrix *results[4] = { C_matrix, C_row, C_element, C_tile };
+    TaskGroup *pending[4] = { &done[0], &done[1], &done[2], &done[3] };
+    int order[4] = { 0, 1, 2, 3 };
+    int failed = 0;
+    for (size_t left = 4; left > 0; left--) 
     {
-        for (int j = 0; j < cols; j++) 
-        {
-            ElementMultArgs *args_elem = malloc(sizeof(ElementMultArgs)); //Dynamically allocates memory for a RowMultArgs struct
-            if (!args_elem) { perror("malloc"); exit(EXIT_FAILURE); }
-
-            //Initialize thread arguments
-            args_elem->A = A;
-            args_elem->B = B;
-            args_elem->C = C_element;
-            args_elem->row = i;
-            args_elem->col = j;
-            if (pthread_create(&threads_element[index], NULL, multiply_element, args_elem) != 0) //spawns a new thread that executes multiply_element.
-            {
-                perror("pthread_create");
-                exit(EXIT_FAILURE);
-            }
-            index++;
-        }
+        size_t g = pool_group_wait_any(pool, pending, left);
+        int m = order[g];
+        failed |= write_result(out_prefix, method_names[m], results[m], pool, binary_output) != 0;
+        pending[g] = pending[left - 1]; // Drop it from the set still being waited for
+        order[g] = order[left - 1];
     }
 
-    // Join all threads AFTER all have been created.
-    pthread_join(thread_matrix, NULL);
-    for (int i = 0; i < rows; i++) 
+    // Method 5 (optional): Strassen recursion, its products spread over the workers as tasks.
+    Matrix *C_strassen = NULL;
+    if (strassen) 
     {
-        pthread_join(threads_row[i], NULL);
+        C_strassen = create_result(pool, rows, cols, type, numa);
+        StrassenArgs args_strassen = { A, B, C_strassen, strassen_cutoff, tile_l2, tile_l1 };
+        multiply_strassen(pool, &args_strassen);
     }
 
-    for (int i = 0; i < total_elements; i++) 
+    if (C_strassen) failed |= write_result(out_prefix, "strassen", C_strassen, pool, binary_output) != 0;  // Method 5
+
+    // Cross-check the methods only when asked
+    if (verify) 
     {
-        pthread_join(threads_element[i], NULL);
+        for (int m = 0; m < 3; m++) failed |= compare_results(results[m], method_names[m], C_tile, "tile");
+        if (C_strassen) failed |= compare_results(C_strassen, "strassen", C_tile, "tile");
+        if (!failed) printf("verify: every method agrees with per_tile\n");
     }
 
-    // ------------------------------
-    // Write result matrices to output files.
-    // ------------------------------
-    char filename[256];
-
-    // Output for method 1
-    snprintf(filename, sizeof(filename), "%s_per_matrix.txt", out_prefix);
-    write_matrix_to_file(filename, C_matrix);
-
-    // Output for method 2
-    snprintf(filename, sizeof(filename), "%s_per_row.txt", out_prefix);
-    write_matrix_to_file(filename, C_row);
-
-    // Output for method 3
-    snprintf(filename, sizeof(filename), "%s_per_element.txt", out_prefix);
-    write_matrix_to_file(filename, C_element);
-
-    // Free all allocated matrices.
+    // Stop the workers and free all allocated matrices.
+    free_pool(pool);
     free_matrix(A);
     free_matrix(B);
+    free_matrix(Bt);
+    free_replicas(B_nodes, place);
+    free_replicas(Bt_nodes, place);
+    free_placement(place);
     free_matrix(C_matrix);
     free_matrix(C_row);
     free_matrix(C_element);
+    free_matrix(C_tile);
+    free_matrix(C_strassen);
 
-    return 0;
+    return failed ? EXIT_FAILURE : 0;
 }
@@ -1,218 +1,32 @@
 #include <stdio.h>   // Standard I/O functions
 #include <stdlib.h>  // Memory management
 #include <string.h>  // String management
-#include <pthread.h> // Thread management
-#include <sys/time.h>    // For clock_gettime()
-
-// Maximum matrix dimensions (not larger than 20x20)
-#define MAX_DIM 105
-
-//------------------------------
-// Matrix Structure and Functions
-//------------------------------
-typedef struct {
-    int rows;          // Number of rows
-    int cols;          // Number of columns
-    int **data;        // 2D array to store matrix elements
-} Matrix;
-
-// Allocate a new matrix with given dimensions; memory is zero‐initialized
-Matrix *create_matrix(int rows, int cols) {
-    Matrix *mat = malloc(sizeof(Matrix)); // Dynamically allocates memory for the Matrix struct
-    if (!mat) {
-        perror("malloc");
-        exit(EXIT_FAILURE);
-    }
-
-    // Set the matrix dimensions using the input arguments
-    mat->rows = rows;
-    mat->cols = cols;
-    mat->data = malloc(rows * sizeof(int *)); // Create an array of pointers, where each pointer will later point to a row of integers
-    if (!mat->data) {
-        perror("malloc");
-        exit(EXIT_FAILURE);
-    }
-
-    for (int i = 0; i < rows; i++) {
-        mat->data[i] = calloc(cols, sizeof(int)); // Allocate memory for a row of cols integers and initializes them to 0
-        if (!mat->data[i]) {
-            perror("calloc");
-            exit(EXIT_FAILURE);
-        }
-    }
-    return mat;
-}
-
-// Free a matrix created by create_matrix()
-void free_matrix(Matrix *mat) {
-    if (mat) { // Check if matrix exists
-        // Free each row's data array
-        for (int i = 0; i < mat->rows; i++) {
-            free(mat->data[i]);  // Release memory for individual rows
-        }
-        free(mat->data);    // Free the array of row pointers
-        free(mat);          // Free the matrix structure itself
-    }
-}
-
-// Reads a matrix from a text file
-Matrix *read_matrix_from_file(const char *filename) {
-    FILE *fp = fopen(filename, "r");
-    if (!fp) {
-        perror(filename);  // Print system error message
-        return NULL;
-    }
-
-    char buffer[256];
-    if (!fgets(buffer, sizeof(buffer), fp)) {
-        fclose(fp);  // Close file before returning
-        return NULL; // File empty or read error
-    }
-
-    int rows, cols;
-    if (sscanf(buffer, "row=%d col=%d", &rows, &cols) != 2) {
-        fprintf(stderr, "Error: invalid header format in %s\n", filename);
-        fclose(fp);
-        return NULL;
-    }
-
-    if (rows > MAX_DIM || cols > MAX_DIM) {
-        fprintf(stderr, "Error: matrix dimensions exceed maximum allowed (%d)\n", MAX_DIM);
-        fclose(fp);
-        return NULL;
-    }
-
-    Matrix *mat = create_matrix(rows, cols);
-
-    for (int i = 0; i < rows; i++) {
-        for (int j = 0; j < cols; j++) {
-            if (fscanf(fp, "%d", &(mat->data[i][j])) != 1) {
-                fprintf(stderr, "Error reading matrix element (%d, %d) from %s\n", i, j, filename);
-                free_matrix(mat);
-                fclose(fp);
-                return NULL;
-            }
-        }
-    }
-
-    fclose(fp);
-    return mat;
-}
-
-// Writes a matrix to a text file in the specified format
-void write_matrix_to_file(const char *filename, Matrix *mat) {
-    FILE *fp = fopen(filename, "w");
-    if (!fp) {
-        perror(filename);  // Display system error message
-        return;            // Abort operation if file can't be opened
-    }
-
-    fprintf(fp, "row=%d col=%d\n", mat->rows, mat->cols);
-
-    for (int i = 0; i < mat->rows; i++) {
-        for (int j = 0; j < mat->cols; j++) {
-            fprintf(fp, "%d ", mat->data[i][j]);
-        }
-        fprintf(fp, "\n");
-    }
-
-    fclose(fp); // Close the file stream
-}
-
-//------------------------------
-// Structures for Thread Arguments
-//------------------------------
-
-// For method 1 (thread per matrix)
-typedef struct {
-    Matrix *A;
-    Matrix *B;
-    Matrix *C;
-} MatMultArgs;
-
-// For method 2 (thread per row)
-typedef struct {
-    Matrix *A;
-    Matrix *B;
-    Matrix *C;
-    int row;
-} RowMultArgs;
-
-// For method 3 (thread per element)
-typedef struct {
-    Matrix *A;
-    Matrix *B;
-    Matrix *C;
-    int row;
-    int col;
-} ElementMultArgs;
-
-//------------------------------
-// Thread Worker Functions
-//------------------------------
-
-// Method 1: One thread computes the entire matrix multiplication.
-void *multiply_matrix(void *arg) {
-    MatMultArgs *args = (MatMultArgs *)arg;
-    Matrix *A = args->A;
-    Matrix *B = args->B;
-    Matrix *C = args->C;
-
-    for (int i = 0; i < A->rows; i++) {
-        for (int j = 0; j < B->cols; j++) {
-            int sum = 0;
-            for (int k = 0; k < A->cols; k++) {
-                sum += A->data[i][k] * B->data[k][j];
-            }
-            C->data[i][j] = sum;
-        }
-    }
-    free(args);
-    return NULL;
-}
-
-// Method 2: thread per row.
-void *multiply_row(void *arg) {
-    RowMultArgs *args = (RowMultArgs *)arg;
-    Matrix *A = args->A;
-    Matrix *B = args->B;
-    Matrix *C = args->C;
-    const int i = args->row;
-
-    for (int j = 0; j < B->cols; j++) {
-        int sum = 0;
-        for (int k = 0; k < A->cols; k++) {
-            sum += A->data[i][k] * B->data[k][j];
-        }
-        C->data[i][j] = sum;
-    }
-    free(args);
-    return NULL;
-}
-
-// Method 3: One thread per element.
-void *multiply_element(void *arg) {
-    ElementMultArgs *args = (ElementMultArgs *)arg;
-    Matrix *A = args->A;
-    Matrix *B = args->B;
-    Matrix *C = args->C;
-    const int i = args->row;
-    const int j = args->col;
-
-    int sum = 0;
-    for (int k = 0; k < A->cols; k++) {
-        sum += A->data[i][k] * B->data[k][j];
-    }
-
-    C->data[i][j] = sum;
-    free(args);
-    return NULL;
+#include <sys/time.h>    // For gettimeofday()
+#include "../matrix.h"
+#include "../pool.h"
+#include "../multiply.h"
+#include "../kernels.h"
+#include "../strassen.h"
+#include "../placement.h"
+
+// Seconds elapsed between two gettimeofday() samples
+static double elapsed(struct timeval start, struct timeval end) {
+    return (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
 }
 
 //------------------------------
 // Main Program
 //------------------------------
 int main(int argc, char *argv[]) {
+    // Leading --pin / --numa options, as for matMultp
+    int pin = 0, numa = 0;
+    while (argc > 1 && (strcmp(argv[1], "--pin") == 0 || strcmp(argv[1], "--numa") == 0)) {
+        if (strcmp(argv[1], "--numa") == 0) numa = 1;
+        pin = 1;
+        argv++;
+        argc--;
+    }
+
     char inA_filename[256], inB_filename[256], out_prefix[256];
     if (argc < 4) {
         strcpy(inA_filename, "a.txt");
@@ -225,8 +39,26 @@ int main(int argc, char *argv[]) {
         out_prefix[sizeof(out_prefix) - 1] = '\0';
     }
 
-    Matrix *A = read_matrix_from_file(inA_filename);
-    Matrix *B = read_matrix_from_file(inB_filename);
+    // The pool is started once, outside the timed regions, so the methods
+    // are compared on task granularity rather than on thread creation.
+    ThreadPool *pool = create_pool(0);
+    printf("Worker pool: %zu threads, %s kernels.\n", pool->num_workers, get_kernels()->name);
+
+    // Pinned workers: report each node's read bandwidth before the methods run
+    Placement *place = pin ? pin_workers(pool) : NULL;
+    if (place) {
+        double gbps[place->num_nodes];
+        measure_node_bandwidth(pool, place, gbps);
+        for (int n = 0; n < place->num_nodes; n++) {
+            int workers = 0;
+            for (size_t w = 0; w < pool->num_workers; w++) workers += place->worker_node[w] == n;
+            printf("Node %d: %d pinned workers, %.2f GB/s read bandwidth.\n", place->node_ids[n], workers, gbps[n]);
+        }
+    }
+    if (numa) pool_set_spread(pool, 1);
+
+    Matrix *A = read_matrix_from_file(inA_filename, pool);
+    Matrix *B = read_matrix_from_file(inB_filename, pool);
     if (!A || !B) {
         fprintf(stderr, "Error reading input matrices.\n");
         exit(EXIT_FAILURE);
@@ -242,96 +74,104 @@ int main(int argc, char *argv[]) {
     int rows = A->rows;
     int cols = B->cols;
 
-    Matrix *C_matrix = create_matrix(rows, cols);  // For method 1
-    Matrix *C_row = create_matrix(rows, cols);     // For method 2
-    Matrix *C_element = create_matrix(rows, cols); // For method 3
+    // With --numa each worker zeroes (first touches) the rows of C it computes
+    Matrix *C_matrix = numa ? create_matrix_placed(pool, rows, cols, MATRIX_INT32) : create_matrix(rows, cols);  // For method 1
+    Matrix *C_row = numa ? create_matrix_placed(pool, rows, cols, MATRIX_INT32) : create_matrix(rows, cols);     // For method 2
+    Matrix *C_element = numa ? create_matrix_placed(pool, rows, cols, MATRIX_INT32) : create_matrix(rows, cols); // For method 3
+    Matrix *C_tile = numa ? create_matrix_placed(pool, rows, cols, MATRIX_INT32) : create_matrix(rows, cols);    // For method 4
+    Matrix *C_strassen = numa ? create_matrix_placed(pool, rows, cols, MATRIX_INT32) : create_matrix(rows, cols); // For method 5
 
     struct timeval start, end;
-    double duration;
 
     // ------------------------------
-    // Method 1: One thread per entire matrix.
+    // Packing: B transposed once, shared by methods 1-3.
     // ------------------------------
     gettimeofday(&start, NULL);
+    Matrix *Bt = pack_transposed(pool, B);
+    gettimeofday(&end, NULL);
+    printf("Packing B (%dx%d transpose) took %.6f seconds.\n", B->rows, B->cols, elapsed(start, end));
 
-    pthread_t thread_matrix;
-    MatMultArgs *args_matrix = malloc(sizeof(MatMultArgs));
-    if (!args_matrix) { perror("malloc"); exit(EXIT_FAILURE); }
-    args_matrix->A = A;
-    args_matrix->B = B;
-    args_matrix->C = C_matrix;
+    // Per-node copies of B and Bt (NULL unless --numa finds several nodes)
+    gettimeofday(&start, NULL);
+    Matrix **B_nodes = numa ? replicate_per_node(pool, place, B) : NULL;
+    Matrix **Bt_nodes = numa ? replicate_per_node(pool, place, Bt) : NULL;
+    gettimeofday(&end, NULL);
+    if (B_nodes) {
+        printf("Copying B and Bt to %d nodes took %.6f seconds.\n", place->num_nodes, elapsed(start, end));
+    }
 
-    pthread_create(&thread_matrix, NULL, multiply_matrix, args_matrix);
-    pthread_join(thread_matrix, NULL);
+    MatMultArgs args_matrix = { A, B, C_matrix, Bt, B_nodes, Bt_nodes };
+    MatMultArgs args_row = { A, B, C_row, Bt, B_nodes, Bt_nodes };
+    MatMultArgs args_element = { A, B, C_element, Bt, B_nodes, Bt_nodes };
+    TileMultArgs args_tile = { A, B, C_tile, DEFAULT_TILE_L2, DEFAULT_TILE_L1, B_nodes };
 
+    // ------------------------------
+    // Method 1: One task for the entire matrix.
+    // ------------------------------
+    gettimeofday(&start, NULL);
+    submit_per_matrix(pool, &args_matrix);
+    pool_wait(pool);
     gettimeofday(&end, NULL);
-    duration = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
-    printf("Method 1 (one thread total) took %.6f seconds.\n", duration);
+    printf("Method 1 (one task total) took %.6f seconds.\n", elapsed(start, end));
 
     // ------------------------------
-    // Method 2: One thread per row.
+    // Method 2: Rows, split down to single rows while workers are idle.
     // ------------------------------
     gettimeofday(&start, NULL);
-
-    pthread_t threads_row[rows];
-    for (int i = 0; i < rows; i++) {
-        RowMultArgs *args_row = malloc(sizeof(RowMultArgs));
-        if (!args_row) { perror("malloc"); exit(EXIT_FAILURE); }
-        args_row->A = A;
-        args_row->B = B;
-        args_row->C = C_row;
-        args_row->row = i;
-        pthread_create(&threads_row[i], NULL, multiply_row, args_row);
-    }
-
-    for (int i = 0; i < rows; i++) {
-        pthread_join(threads_row[i], NULL);
-    }
-
+    submit_per_row(pool, &args_row);
+    pool_wait(pool);
     gettimeofday(&end, NULL);
-    duration = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
-    printf("Method 2 (one thread per row) took %.6f seconds.\n", duration);
+    printf("Method 2 (per row, %d rows) took %.6f seconds.\n", rows, elapsed(start, end));
 
     // ------------------------------
-    // Method 3: One thread per element.
+    // Method 3: Elements, split down to single elements while workers are idle.
     // ------------------------------
     gettimeofday(&start, NULL);
+    submit_per_element(pool, &args_element);
+    pool_wait(pool);
+    gettimeofday(&end, NULL);
+    printf("Method 3 (per element, %zu elements) took %.6f seconds.\n",
+           (size_t)rows * cols, elapsed(start, end));
 
-    pthread_t threads_element[rows * cols];
-    int index = 0;
-    for (int i = 0; i < rows; i++) {
-        for (int j = 0; j < cols; j++) {
-            ElementMultArgs *args_elem = malloc(sizeof(ElementMultArgs));
-            if (!args_elem) { perror("malloc"); exit(EXIT_FAILURE); }
-            args_elem->A = A;
-            args_elem->B = B;
-            args_elem->C = C_element;
-            args_elem->row = i;
-            args_elem->col = j;
-            pthread_create(&threads_element[index], NULL, multiply_element, args_elem);
-            index++;
-        }
-    }
-
-    for (int i = 0; i < rows * cols; i++) {
-        pthread_join(threads_element[i], NULL);
-    }
+    // ------------------------------
+    // Method 4: Cache-blocked output tiles.
+    // ------------------------------
+    gettimeofday(&start, NULL);
+    submit_per_tile(pool, &args_tile);
+    pool_wait(pool);
+    gettimeofday(&end, NULL);
+    printf("Method 4 (per tile, %dx%d tiles) took %.6f seconds.\n",
+           args_tile.tile_l2, args_tile.tile_l2, elapsed(start, end));
 
+    // ------------------------------
+    // Method 5: Strassen recursion over the tiled kernel.
+    // ------------------------------
+    StrassenArgs args_strassen = { A, B, C_strassen, DEFAULT_STRASSEN_CUTOFF, DEFAULT_TILE_L2, DEFAULT_TILE_L1 };
+    gettimeofday(&start, NULL);
+    multiply_strassen(pool, &args_strassen);
     gettimeofday(&end, NULL);
-    duration = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
-    printf("Method 3 (one thread per element) took %.6f seconds.\n", duration);
-    
+    printf("Method 5 (Strassen, cutoff %d) took %.6f seconds.\n", DEFAULT_STRASSEN_CUTOFF, elapsed(start, end));
+
     // Write the results to files
-    write_matrix_to_file("C_matrix.txt", C_matrix);
-    write_matrix_to_file("C_row.txt", C_row);
-    write_matrix_to_file("C_element.txt", C_element);
+    write_matrix_to_file("C_matrix.txt", C_matrix, pool);
+    write_matrix_to_file("C_row.txt", C_row, pool);
+    write_matrix_to_file("C_element.txt", C_element, pool);
+    write_matrix_to_file("C_tile.txt", C_tile, pool);
+    write_matrix_to_file("C_strassen.txt", C_strassen, pool);
 
     // Free allocated memory
+    free_pool(pool);
     free_matrix(A);
     free_matrix(B);
+    free_matrix(Bt);
+    free_replicas(B_nodes, place);
+    free_replicas(Bt_nodes, place);
+    free_placement(place);
     free_matrix(C_matrix);
     free_matrix(C_row);
     free_matrix(C_element);
+    free_matrix(C_tile);
+    free_matrix(C_strassen);
 
     return 0;
 }
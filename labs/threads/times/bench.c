@@ -0,0 +1,465 @@
+#include <stdio.h>   // Standard I/O functions
+#include <stdlib.h>  // Memory management
+#include <string.h>  // String management
+#include <stdint.h>  // int64_t
+#include <getopt.h>  // Command-line option parsing
+#include <time.h>    // clock_gettime()
+#include <errno.h>   // ENOMEM from posix_memalign()
+#include <stdatomic.h>
+#include "../matrix.h"
+#include "../pool.h"
+#include "../multiply.h"
+#include "../kernels.h"
+#include "../strassen.h"
+#include "../counters.h"
+
+//------------------------------
+// Benchmark harness
+//------------------------------
+// Generates A and B in memory, then for each method runs warmups followed by timed
+// repetitions and reports min / median / p99 wall time with the derived GFLOP/s
+// (2*rows*inner*cols per product) and GB/s (A, B and C each moved once), as a
+// table, CSV or JSON, along with the heap allocations one run makes. With
+// --counters, each worker's hardware counters over the timed runs are added to the
+// report, per run, for every worker and in total.
+
+#define MAX_METHODS 6
+
+typedef struct {
+    const char *method;
+    double min, median, p99;   // Seconds
+    double gflops, gbps;       // From the minimum
+    double allocs;             // Heap allocations per timed run (whole process)
+    double *counts;            // Per-run counter averages: row 0 the sum over workers, then
+                               // one row per worker, COUNTER_COUNT each (NULL: not counted)
+} BenchResult;
+
+typedef struct {
+    Matrix *A, *B, *C, *Bt;
+    ThreadPool *pool;
+    WorkerCounters *counters;  // NULL without --counters (or when none are available)
+} BenchData;
+
+//------------------------------
+// Allocation counting
+//------------------------------
+// The allocator entry points are replaced for the whole process (engine and libc
+// alike): each call is counted and handed on to glibc's own implementation.
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void *__libc_memalign(size_t align, size_t size);
+
+static atomic_size_t heap_allocations;
+
+static void count_allocation(void) {
+    atomic_fetch_add_explicit(&heap_allocations, 1, memory_order_relaxed);
+}
+
+void *malloc(size_t size) {
+    count_allocation();
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size) {
+    count_allocation();
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    count_allocation();
+    return __libc_realloc(ptr, size);
+}
+
+void *aligned_alloc(size_t align, size_t size) {
+    count_allocation();
+    return __libc_memalign(align, size);
+}
+
+int posix_memalign(void **out, size_t align, size_t size) {
+    count_allocation();
+    void *ptr = __libc_memalign(align, size);
+    if (!ptr) return ENOMEM;
+    *out = ptr;
+    return 0;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Deterministic pseudo-random contents: small integers, or values in [-1, 1)
+static void fill_matrix(Matrix *mat, unsigned seed) {
+    for (int i = 0; i < mat->rows; i++) {
+        for (int j = 0; j < mat->cols; j++) {
+            seed = seed * 1103515245u + 12345u;
+            const int v = (int)(seed >> 16) % 201 - 100;
+            switch (mat->type) {
+                case MATRIX_INT64:  MAT_ROW_AS(int64_t, mat, i)[j] = v; break;
+                case MATRIX_FLOAT:  MAT_ROW_AS(float, mat, i)[j] = v / 100.0f; break;
+                case MATRIX_DOUBLE: MAT_ROW_AS(double, mat, i)[j] = v / 100.0; break;
+                default:            MAT_ROW(mat, i)[j] = v; break;
+            }
+        }
+    }
+}
+
+//------------------------------
+// Methods
+//------------------------------
+
+static void run_pack(BenchData *d) {
+    free_matrix(d->Bt);
+    d->Bt = pack_transposed(d->pool, d->B);
+}
+
+static void run_matrix(BenchData *d) {
+    MatMultArgs args = { d->A, d->B, d->C, d->Bt };
+    submit_per_matrix(d->pool, &args);
+    pool_wait(d->pool);
+}
+
+static void run_row(BenchData *d) {
+    MatMultArgs args = { d->A, d->B, d->C, d->Bt };
+    submit_per_row(d->pool, &args);
+    pool_wait(d->pool);
+}
+
+static void run_element(BenchData *d) {
+    MatMultArgs args = { d->A, d->B, d->C, d->Bt };
+    submit_per_element(d->pool, &args);
+    pool_wait(d->pool);
+}
+
+static void run_tile(BenchData *d) {
+    TileMultArgs args = { d->A, d->B, d->C, DEFAULT_TILE_L2, DEFAULT_TILE_L1 };
+    submit_per_tile(d->pool, &args);
+    pool_wait(d->pool);
+}
+
+static void run_strassen(BenchData *d) {
+    StrassenArgs args = { d->A, d->B, d->C, DEFAULT_STRASSEN_CUTOFF, DEFAULT_TILE_L2, DEFAULT_TILE_L1 };
+    multiply_strassen(d->pool, &args);
+}
+
+typedef struct {
+    const char *name;
+    void (*run)(BenchData *d);
+    int int32_only;
+    int is_product;   // Counts toward GFLOP/s (packing only moves B)
+} BenchMethod;
+
+static const BenchMethod methods[MAX_METHODS] = {
+    { "pack",     run_pack,     1, 0 },
+    { "matrix",   run_matrix,   0, 1 },
+    { "row",      run_row,      0, 1 },
+    { "element",  run_element,  0, 1 },
+    { "tile",     run_tile,     0, 1 },
+    { "strassen", run_strassen, 1, 1 },
+};
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Warmups, then reps timed runs of one method
+static BenchResult bench_method(const BenchMethod *m, BenchData *d, int warmup, int reps) {
+    double *times = malloc((size_t)reps * sizeof(double));
+    if (!times) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    const size_t slots = d->pool->num_workers * COUNTER_COUNT;
+    uint64_t *before = NULL, *after = NULL;
+    if (d->counters) {
+        before = malloc(slots * sizeof(uint64_t));
+        after = malloc(slots * sizeof(uint64_t));
+        if (!before || !after) {
+            perror("malloc");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    for (int r = 0; r < warmup; r++) m->run(d);
+    if (d->counters) read_worker_counters(d->counters, before);
+    const size_t allocs_before = atomic_load(&heap_allocations);
+    for (int r = 0; r < reps; r++) {
+        const double start = now_seconds();
+        m->run(d);
+        times[r] = now_seconds() - start;
+    }
+    const size_t allocs = atomic_load(&heap_allocations) - allocs_before;
+    if (d->counters) read_worker_counters(d->counters, after);
+    qsort(times, (size_t)reps, sizeof(double), compare_doubles);
+
+    BenchResult res = { m->name };
+    res.allocs = (double)allocs / reps;
+    if (d->counters) {
+        res.counts = calloc(slots + COUNTER_COUNT, sizeof(double));
+        if (!res.counts) {
+            perror("calloc");
+            exit(EXIT_FAILURE);
+        }
+        for (size_t slot = 0; slot < slots; slot++) {
+            const double per_run = (double)(after[slot] - before[slot]) / reps;
+            res.counts[COUNTER_COUNT + slot] = per_run;
+            res.counts[slot % COUNTER_COUNT] += per_run;
+        }
+        free(before);
+        free(after);
+    }
+    res.min = times[0];
+    res.median = reps % 2 ? times[reps / 2] : (times[reps / 2 - 1] + times[reps / 2]) / 2;
+    int p99_rank = (99 * reps + 99) / 100;   // Nearest rank: ceil(0.99 * reps)
+    res.p99 = times[p99_rank - 1];
+
+    const double elem = (double)matrix_type_size(d->C->type);
+    const double rows = d->A->rows, inner = d->A->cols, cols = d->B->cols;
+    if (m->is_product) {
+        res.gflops = 2 * rows * inner * cols / res.min / 1e9;
+        res.gbps = (rows * inner + inner * cols + rows * cols) * elem / res.min / 1e9;
+    } else {
+        res.gbps = 2 * inner * cols * elem / res.min / 1e9;   // B read, Bt written
+    }
+    free(times);
+    return res;
+}
+
+//------------------------------
+// Reports
+//------------------------------
+
+typedef struct {
+    int rows, inner, cols;
+    const char *type;
+    size_t threads;
+    const char *kernels;
+    int warmup, reps;
+    const WorkerCounters *counters;   // Which events were counted (NULL: none)
+} BenchSetup;
+
+// One event of a counter row (0 the total, 1..threads the workers), or missing when not counted
+static void print_count(const BenchSetup *s, const double *counts, int event, const char *fmt, const char *missing) {
+    if (s->counters->available[event]) printf(fmt, counts[event]);
+    else printf("%s", missing);
+}
+
+static void print_table(const BenchSetup *s, const BenchResult *res, int n) {
+    printf("A=%dx%d B=%dx%d %s, %zu threads, %s kernels, %d warmups + %d reps\n",
+           s->rows, s->inner, s->inner, s->cols, s->type, s->threads, s->kernels, s->warmup, s->reps);
+    printf("%-10s %12s %12s %12s %10s %10s %11s\n", "method", "min_s", "median_s", "p99_s", "GFLOP/s", "GB/s",
+           "allocs/run");
+    for (int i = 0; i < n; i++) {
+        printf("%-10s %12.6f %12.6f %12.6f %10.3f %10.3f %11.1f\n", res[i].method, res[i].min, res[i].median,
+               res[i].p99, res[i].gflops, res[i].gbps, res[i].allocs);
+    }
+    if (!s->counters) return;
+
+    printf("\nHardware counters per run\n%-10s %-6s", "method", "worker");
+    for (int e = 0; e < COUNTER_COUNT; e++) printf(" %14s", counter_name(e));
+    printf(" %6s\n", "IPC");
+    for (int i = 0; i < n; i++) {
+        for (size_t row = 0; row <= s->threads; row++) {
+            const double *counts = res[i].counts + row * COUNTER_COUNT;
+            if (row == 0) printf("%-10s %-6s", res[i].method, "all");
+            else printf("%-10s %-6zu", "", row - 1);
+            for (int e = 0; e < COUNTER_COUNT; e++) print_count(s, counts, e, " %14.0f", "              -");
+            if (s->counters->available[COUNTER_CYCLES] && s->counters->available[COUNTER_INSTRUCTIONS]
+                && counts[COUNTER_CYCLES] > 0) {
+                printf(" %6.2f", counts[COUNTER_INSTRUCTIONS] / counts[COUNTER_CYCLES]);
+            }
+            printf("\n");
+        }
+    }
+}
+
+// With counters, each method gets a row per worker after its "all" row; the timing
+// columns repeat, and events that could not be counted are left empty
+static void print_csv(const BenchSetup *s, const BenchResult *res, int n) {
+    printf("method,rows,inner,cols,type,threads,kernels,warmup,reps,min_s,median_s,p99_s,gflops,gbps,allocs_per_run");
+    if (s->counters) {
+        printf(",worker");
+        for (int e = 0; e < COUNTER_COUNT; e++) printf(",%s", counter_name(e));
+    }
+    printf("\n");
+    for (int i = 0; i < n; i++) {
+        const size_t rows = s->counters ? s->threads + 1 : 1;
+        for (size_t row = 0; row < rows; row++) {
+            printf("%s,%d,%d,%d,%s,%zu,%s,%d,%d,%.9f,%.9f,%.9f,%.6f,%.6f,%.3f", res[i].method, s->rows, s->inner,
+                   s->cols, s->type, s->threads, s->kernels, s->warmup, s->reps, res[i].min, res[i].median,
+                   res[i].p99, res[i].gflops, res[i].gbps, res[i].allocs);
+            if (s->counters) {
+                if (row == 0) printf(",all");
+                else printf(",%zu", row - 1);
+                for (int e = 0; e < COUNTER_COUNT; e++) print_count(s, res[i].counts + row * COUNTER_COUNT, e, ",%.0f", ",");
+            }
+            printf("\n");
+        }
+    }
+}
+
+// {"cycles": ..., ...} for one counter row, null for events that were not counted
+static void print_json_counts(const BenchSetup *s, const double *counts) {
+    printf("{");
+    for (int e = 0; e < COUNTER_COUNT; e++) {
+        printf("%s\"%s\": ", e ? ", " : " ", counter_name(e));
+        print_count(s, counts, e, "%.0f", "null");
+    }
+    printf(" }");
+}
+
+static void print_json(const BenchSetup *s, const BenchResult *res, int n) {
+    printf("{\n  \"rows\": %d, \"inner\": %d, \"cols\": %d, \"type\": \"%s\",\n", s->rows, s->inner, s->cols, s->type);
+    printf("  \"threads\": %zu, \"kernels\": \"%s\", \"warmup\": %d, \"reps\": %d,\n", s->threads, s->kernels,
+           s->warmup, s->reps);
+    printf("  \"results\": [\n");
+    for (int i = 0; i < n; i++) {
+        printf("    { \"method\": \"%s\", \"min_s\": %.9f, \"median_s\": %.9f, \"p99_s\": %.9f, "
+               "\"gflops\": %.6f, \"gbps\": %.6f, \"allocs_per_run\": %.3f", res[i].method, res[i].min, res[i].median,
+               res[i].p99, res[i].gflops, res[i].gbps, res[i].allocs);
+        if (s->counters) {
+            printf(",\n      \"counters\": ");
+            print_json_counts(s, res[i].counts);
+            printf(",\n      \"workers\": [");
+            for (size_t w = 0; w < s->threads; w++) {
+                printf("%s\n        ", w ? "," : "");
+                print_json_counts(s, res[i].counts + (w + 1) * COUNTER_COUNT);
+            }
+            printf("\n      ]\n    ");
+        }
+        printf(" }%s\n", i + 1 < n ? "," : "");
+    }
+    printf("  ]\n}\n");
+}
+
+//------------------------------
+// Main Program
+//------------------------------
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [options]\n"
+                    "  --size=N          rows, inner and cols at once (default 512)\n"
+                    "  --rows=N --inner=N --cols=N   shape of A (rows x inner) and B (inner x cols)\n"
+                    "  --type=TYPE       int32, int64, float or double (default int32)\n"
+                    "  --threads=N       pool size (default: online CPUs)\n"
+                    "  --kernel=NAME     avx512, avx2 or scalar (default: best for this CPU)\n"
+                    "  --methods=LIST    comma-separated subset of pack,matrix,row,element,tile,strassen\n"
+                    "                    (default: all that support the type)\n"
+                    "  --warmup=N        untimed runs per method (default 2)\n"
+                    "  --reps=N          timed runs per method (default 10)\n"
+                    "  --format=FMT      table, csv or json (default table)\n"
+                    "  --counters        add per-worker hardware counters (cycles, instructions, L1D, LLC\n"
+                    "                    and dTLB read misses) to the report, when perf_event_open allows\n", prog);
+}
+
+int main(int argc, char *argv[]) {
+    int rows = 512, inner = 512, cols = 512;
+    int warmup = 2, reps = 10;
+    size_t threads = 0;
+    MatrixType type = MATRIX_INT32;
+    const char *method_list = NULL;
+    const char *format = "table";
+    int counters = 0;
+
+    static const struct option long_options[] = {
+        { "size",    required_argument, NULL, 'n' },
+        { "rows",    required_argument, NULL, 'r' },
+        { "inner",   required_argument, NULL, 'i' },
+        { "cols",    required_argument, NULL, 'c' },
+        { "type",    required_argument, NULL, 't' },
+        { "threads", required_argument, NULL, 'j' },
+        { "kernel",  required_argument, NULL, 'k' },
+        { "methods", required_argument, NULL, 'm' },
+        { "warmup",  required_argument, NULL, 'w' },
+        { "reps",    required_argument, NULL, 'R' },
+        { "format",  required_argument, NULL, 'f' },
+        { "counters", no_argument,      NULL, 'C' },
+        { "help",    no_argument,       NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "h", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'n': rows = inner = cols = atoi(optarg); break;
+            case 'r': rows = atoi(optarg); break;
+            case 'i': inner = atoi(optarg); break;
+            case 'c': cols = atoi(optarg); break;
+            case 't': if (parse_matrix_type(optarg, &type) != 0) return EXIT_FAILURE; break;
+            case 'j': threads = (size_t)atoi(optarg); break;
+            case 'k': if (select_kernels(optarg) != 0) return EXIT_FAILURE; break;
+            case 'm': method_list = optarg; break;
+            case 'w': warmup = atoi(optarg); break;
+            case 'R': reps = atoi(optarg); break;
+            case 'f': format = optarg; break;
+            case 'C': counters = 1; break;
+            case 'h': usage(argv[0]); return 0;
+            default:  usage(argv[0]); return EXIT_FAILURE;
+        }
+    }
+    if (rows <= 0 || inner <= 0 || cols <= 0 || warmup < 0 || reps <= 0) {
+        fprintf(stderr, "Error: sizes and --reps must be positive, --warmup non-negative.\n");
+        return EXIT_FAILURE;
+    }
+    if (strcmp(format, "table") != 0 && strcmp(format, "csv") != 0 && strcmp(format, "json") != 0) {
+        fprintf(stderr, "Error: unknown format '%s'.\n", format);
+        return EXIT_FAILURE;
+    }
+
+    // Methods to run, in table order
+    int selected[MAX_METHODS] = { 0 };
+    for (int m = 0; m < MAX_METHODS; m++) selected[m] = !method_list && (type == MATRIX_INT32 || !methods[m].int32_only);
+    if (method_list) {
+        char list[256];
+        snprintf(list, sizeof(list), "%s", method_list);
+        for (char *name = strtok(list, ","); name; name = strtok(NULL, ",")) {
+            int found = 0;
+            for (int m = 0; m < MAX_METHODS; m++) {
+                if (strcmp(name, methods[m].name) != 0) continue;
+                if (methods[m].int32_only && type != MATRIX_INT32) {
+                    fprintf(stderr, "Error: method '%s' only supports int32 elements.\n", name);
+                    return EXIT_FAILURE;
+                }
+                selected[m] = found = 1;
+            }
+            if (!found) {
+                fprintf(stderr, "Error: unknown method '%s'.\n", name);
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    BenchData d = { 0 };
+    d.pool = create_pool(threads);
+    d.A = create_matrix_typed(rows, inner, type);
+    d.B = create_matrix_typed(inner, cols, type);
+    d.C = create_matrix_typed(rows, cols, type);
+    fill_matrix(d.A, 1);
+    fill_matrix(d.B, 2);
+    if (type == MATRIX_INT32) d.Bt = pack_transposed(d.pool, d.B); // Methods 1-3 read B packed, as in matMultp
+    if (counters) d.counters = open_worker_counters(d.pool); // Without them the report just has no counter columns
+
+    BenchResult results[MAX_METHODS];
+    int n = 0;
+    for (int m = 0; m < MAX_METHODS; m++) {
+        if (selected[m]) results[n++] = bench_method(&methods[m], &d, warmup, reps);
+    }
+
+    BenchSetup setup = { rows, inner, cols, matrix_type_name(type), d.pool->num_workers, get_kernels()->name, warmup, reps,
+                         d.counters };
+    if (strcmp(format, "csv") == 0) print_csv(&setup, results, n);
+    else if (strcmp(format, "json") == 0) print_json(&setup, results, n);
+    else print_table(&setup, results, n);
+
+    for (int i = 0; i < n; i++) free(results[i].counts);
+    close_worker_counters(d.counters);
+    free_pool(d.pool);
+    free_matrix(d.A);
+    free_matrix(d.B);
+    free_matrix(d.C);
+    free_matrix(d.Bt);
+    return 0;
+}
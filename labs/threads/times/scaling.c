@@ -0,0 +1,86 @@
+#include <stdio.h>   // Standard I/O functions
+#include <stdlib.h>  // Memory management
+#include <sys/time.h>    // For gettimeofday()
+#include "../matrix.h"
+#include "../pool.h"
+#include "../multiply.h"
+#include "../kernels.h"
+
+// Seconds elapsed between two gettimeofday() samples
+static double elapsed(struct timeval start, struct timeval end) {
+    return (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
+}
+
+// Fill a matrix with small incrementing values (same pattern as creat.c, kept small to avoid overflow)
+static void fill_matrix(Matrix *mat) {
+    for (int i = 0; i < mat->rows; i++) {
+        for (int j = 0; j < mat->cols; j++) {
+            MAT_ROW(mat, i)[j] = (i * mat->cols + j) % 100 + 1;
+        }
+    }
+}
+
+//------------------------------
+// Main Program
+//------------------------------
+// Usage: ./scaling [rows] [inner] [cols] [max_threads]
+// Times the four methods on pools of 1..max_threads workers (default: online CPUs).
+int main(int argc, char *argv[]) {
+    int rows = argc > 1 ? atoi(argv[1]) : 512;
+    int inner = argc > 2 ? atoi(argv[2]) : rows;
+    int cols = argc > 3 ? atoi(argv[3]) : rows;
+    size_t max_threads = argc > 4 ? (size_t)atoi(argv[4]) : online_cpus();
+    if (rows <= 0 || inner <= 0 || cols <= 0 || max_threads == 0) {
+        fprintf(stderr, "Usage: %s [rows] [inner] [cols] [max_threads]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    Matrix *A = create_matrix(rows, inner);
+    Matrix *B = create_matrix(inner, cols);
+    Matrix *C = create_matrix(rows, cols);
+    fill_matrix(A);
+    fill_matrix(B);
+    MatMultArgs args = { A, B, C, NULL };
+    TileMultArgs tile_args = { A, B, C, DEFAULT_TILE_L2, DEFAULT_TILE_L1 };
+
+    const char *names[4] = { "per_matrix", "per_row", "per_element", "per_tile" };
+    void (*submit[3])(ThreadPool *, MatMultArgs *) = { submit_per_matrix, submit_per_row, submit_per_element };
+    double base[4] = { 0, 0, 0, 0 };
+
+    printf("A=%dx%d B=%dx%d, %s kernels\n", rows, inner, inner, cols, get_kernels()->name);
+    printf("%-8s %-12s %12s %8s %8s %8s\n", "threads", "method", "seconds", "speedup", "steals", "splits");
+    for (size_t threads = 1; threads <= max_threads; threads++) {
+        ThreadPool *pool = create_pool(threads);
+        struct timeval start, end;
+
+        // Packing is timed on its own; the packed copy is shared by methods 1-3
+        gettimeofday(&start, NULL);
+        args.Bt = pack_transposed(pool, B);
+        gettimeofday(&end, NULL);
+        printf("%-8zu %-12s %12.6f\n", threads, "pack_B", elapsed(start, end));
+
+        for (int m = 0; m < 4; m++) {
+            size_t steals = atomic_load(&pool->steals);
+            size_t splits = atomic_load(&pool->splits);
+
+            gettimeofday(&start, NULL);
+            if (m < 3) submit[m](pool, &args);
+            else submit_per_tile(pool, &tile_args);
+            pool_wait(pool);
+            gettimeofday(&end, NULL);
+
+            double seconds = elapsed(start, end);
+            if (threads == 1) base[m] = seconds;
+            printf("%-8zu %-12s %12.6f %8.2f %8zu %8zu\n", threads, names[m], seconds,
+                   base[m] / seconds, atomic_load(&pool->steals) - steals,
+                   atomic_load(&pool->splits) - splits);
+        }
+        free_matrix(args.Bt);
+        free_pool(pool);
+    }
+
+    free_matrix(A);
+    free_matrix(B);
+    free_matrix(C);
+    return 0;
+}
@@ -0,0 +1,216 @@
+#include <stdio.h>   // Standard I/O functions
+#include <stdlib.h>  // Memory management
+#include <string.h>  // String management
+#include <stdint.h>  // int64_t
+#include <unistd.h>  // gethostname()
+#include <time.h>    // clock_gettime()
+#include "tune.h"
+#include "multiply.h"
+#include "kernels.h"
+
+static const char *const method_names[] = { "matrix", "row", "element", "tile" };
+
+const char *tune_method_name(TuneMethod method) {
+
+    return method_names[method];
+}
+
+static double now_seconds(void) {
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void host_name(char *out, size_t size) {
+
+    if (gethostname(out, size) != 0) snprintf(out, size, "unknown");
+    out[size - 1] = '\0';
+    for (char *c = out; *c; c++) if (*c == ' ') *c = '_'; // Keep the cache whitespace-separated
+}
+
+//------------------------------
+// Tuning File
+//------------------------------
+
+int tune_lookup(const char *filename, int rows, int inner, int cols, MatrixType type, TuneConfig *config) {
+
+    FILE *fp = fopen(filename, "r");
+    if (!fp) 
+    {
+        return -1; // No cache yet
+    }
+
+    char host[256], line[512];
+    host_name(host, sizeof(host));
+    const char *kernels[8];
+    const size_t num_kernels = available_kernels(kernels, 8);
+
+    int found = 0;
+    while (fgets(line, sizeof(line), fp)) 
+    {
+        char l_host[256], l_type[16], l_method[16], l_kernel[16];
+        int l_rows, l_inner, l_cols;
+        TuneConfig c;
+        if (line[0] == '#' || sscanf(line, "%255s %d %d %d %15s %15s %15s %zu %lf", l_host, &l_rows, &l_inner, &l_cols,
+                                     l_type, l_method, l_kernel, &c.threads, &c.seconds) != 9) 
+        {
+            continue;
+        }
+        if (strcmp(l_host, host) != 0 || l_rows != rows || l_inner != inner || l_cols != cols
+            || strcmp(l_type, matrix_type_name(type)) != 0 || c.threads == 0) 
+        {
+            continue;
+        }
+
+        // Skip entries this build or CPU cannot honour
+        int method = -1;
+        for (int m = 0; m < (int)(sizeof(method_names) / sizeof(method_names[0])); m++) 
+        {
+            if (strcmp(l_method, method_names[m]) == 0) method = m;
+        }
+        int kernel_ok = 0;
+        for (size_t k = 0; k < num_kernels; k++) kernel_ok |= strcmp(l_kernel, kernels[k]) == 0;
+        if (method < 0 || !kernel_ok) 
+        {
+            continue;
+        }
+        c.method = (TuneMethod)method;
+        snprintf(c.kernel, sizeof(c.kernel), "%s", l_kernel);
+        *config = c;
+        found = 1;
+    }
+    fclose(fp);
+    return found ? 0 : -1;
+}
+
+int tune_store(const char *filename, int rows, int inner, int cols, MatrixType type, const TuneConfig *config) {
+
+    FILE *fp = fopen(filename, "a");
+    if (!fp) 
+    {
+        perror(filename);
+        return -1;
+    }
+    char host[256];
+    host_name(host, sizeof(host));
+    if (ftell(fp) == 0) 
+    {
+        fprintf(fp, "# matMultp --auto tuning cache: host rows inner cols type method kernel threads seconds\n");
+    }
+    fprintf(fp, "%s %d %d %d %s %s %s %zu %.9f\n", host, rows, inner, cols, matrix_type_name(type),
+            tune_method_name(config->method), config->kernel, config->threads, config->seconds);
+    return fclose(fp) == 0 ? 0 : -1;
+}
+
+//------------------------------
+// Running a Configuration
+//------------------------------
+
+// Runs the method on an already sized pool with the kernels already selected.
+// Rows and elements of int32 products read a packed B, as in the normal run.
+static void run_method(ThreadPool *pool, TuneMethod method, Matrix *A, Matrix *B, Matrix *C) {
+
+    if (method == TUNE_PER_TILE) 
+    {
+        TileMultArgs args = { A, B, C, DEFAULT_TILE_L2, DEFAULT_TILE_L1 };
+        submit_per_tile(pool, &args);
+        pool_wait(pool);
+        return;
+    }
+
+    Matrix *Bt = C->type == MATRIX_INT32 ? pack_transposed(pool, B) : NULL;
+    MatMultArgs args = { A, B, C, Bt };
+    switch (method) 
+    {
+        case TUNE_PER_MATRIX:  submit_per_matrix(pool, &args); break;
+        case TUNE_PER_ROW:     submit_per_row(pool, &args); break;
+        default:               submit_per_element(pool, &args); break;
+    }
+    pool_wait(pool);
+    free_matrix(Bt);
+}
+
+void tune_multiply(ThreadPool *pool, const TuneConfig *config, Matrix *A, Matrix *B, Matrix *C) {
+
+    select_kernels(config->kernel); // Checked against the CPU when the config was made
+    run_method(pool, config->method, A, B, C);
+}
+
+//------------------------------
+// Probing
+//------------------------------
+
+// Deterministic pseudo-random contents (small integers, or values in [-1, 1))
+static void fill_probe(Matrix *mat, unsigned seed) {
+
+    for (int i = 0; i < mat->rows; i++) 
+    {
+        for (int j = 0; j < mat->cols; j++) 
+        {
+            seed = seed * 1103515245u + 12345u;
+            const int v = (int)(seed >> 16) % 201 - 100;
+            switch (mat->type) 
+            {
+                case MATRIX_INT64:  MAT_ROW_AS(int64_t, mat, i)[j] = v; break;
+                case MATRIX_FLOAT:  MAT_ROW_AS(float, mat, i)[j] = v / 100.0f; break;
+                case MATRIX_DOUBLE: MAT_ROW_AS(double, mat, i)[j] = v / 100.0; break;
+                default:            MAT_ROW(mat, i)[j] = v; break;
+            }
+        }
+    }
+}
+
+static int probe_edge(int n) {
+
+    return n < TUNE_PROBE_EDGE ? n : TUNE_PROBE_EDGE;
+}
+
+void tune_probe(int rows, int inner, int cols, MatrixType type, TuneConfig *config) {
+
+    Matrix *A = create_matrix_typed(probe_edge(rows), probe_edge(inner), type);
+    Matrix *B = create_matrix_typed(probe_edge(inner), probe_edge(cols), type);
+    Matrix *C = create_matrix_typed(probe_edge(rows), probe_edge(cols), type);
+    fill_probe(A, 1);
+    fill_probe(B, 2);
+
+    const char *kernels[8];
+    const size_t num_kernels = available_kernels(kernels, 8);
+    const size_t cpus = online_cpus();
+    config->seconds = -1;
+
+    for (size_t threads = 1; ; threads = threads * 2 < cpus ? threads * 2 : cpus) 
+    {
+        ThreadPool *pool = create_pool(threads);
+        for (size_t k = 0; k < num_kernels; k++) 
+        {
+            select_kernels(kernels[k]);
+            for (int m = TUNE_PER_MATRIX; m <= TUNE_PER_TILE; m++) 
+            {
+                if (m == TUNE_PER_MATRIX && threads > 1) continue; // One task uses one worker anyway
+
+                double best = -1;
+                for (int rep = 0; rep < TUNE_PROBE_REPS; rep++) 
+                {
+                    const double start = now_seconds();
+                    run_method(pool, (TuneMethod)m, A, B, C);
+                    const double seconds = now_seconds() - start;
+                    if (best < 0 || seconds < best) best = seconds;
+                }
+                if (config->seconds < 0 || best < config->seconds) 
+                {
+                    config->method = (TuneMethod)m;
+                    snprintf(config->kernel, sizeof(config->kernel), "%s", kernels[k]);
+                    config->threads = threads;
+                    config->seconds = best;
+                }
+            }
+        }
+        free_pool(pool);
+        if (threads == cpus) break;
+    }
+
+    free_matrix(A);
+    free_matrix(B);
+    free_matrix(C);
+}
@@ -0,0 +1,42 @@
+#ifndef TUNE_H
+#define TUNE_H
+
+#include "matrix.h"
+#include "pool.h"
+
+// Tuning cache used by --auto unless --tuning-file says otherwise
+#define DEFAULT_TUNING_FILE "matmult.tune"
+
+// Probes are the real shape with every dimension capped at this edge
+#define TUNE_PROBE_EDGE 256
+#define TUNE_PROBE_REPS 3     // Each candidate keeps its fastest of this many runs
+
+typedef enum { TUNE_PER_MATRIX, TUNE_PER_ROW, TUNE_PER_ELEMENT, TUNE_PER_TILE } TuneMethod;
+
+// One way of running a product: method, kernel set and pool size
+typedef struct {
+    TuneMethod method;
+    char kernel[16];
+    size_t threads;
+    double seconds;    // Probe time of this configuration
+} TuneConfig;
+
+// Function prototypes
+const char *tune_method_name(TuneMethod method);   // "matrix", "row", "element" or "tile"
+
+// Cached winner for (rows x inner) x (inner x cols) of this type on this host, from
+// the tuning file (lines "host rows inner cols type method kernel threads seconds";
+// the last matching line wins). Returns 0 when found.
+int tune_lookup(const char *filename, int rows, int inner, int cols, MatrixType type, TuneConfig *config);
+
+// Times every method, supported kernel set and pool size (1, 2, 4, ... up to the
+// online CPUs) on a probe of the shape, and returns the fastest combination
+void tune_probe(int rows, int inner, int cols, MatrixType type, TuneConfig *config);
+
+// Appends a winner to the tuning file; -1 (after a message) when it cannot be written
+int tune_store(const char *filename, int rows, int inner, int cols, MatrixType type, const TuneConfig *config);
+
+// C = A x B with config's kernels and method on pool (sized config->threads). Blocks.
+void tune_multiply(ThreadPool *pool, const TuneConfig *config, Matrix *A, Matrix *B, Matrix *C);
+
+#endif